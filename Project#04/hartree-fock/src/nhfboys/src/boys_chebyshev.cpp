@@ -0,0 +1,171 @@
+#include "boys_chebyshev.hpp"
+#include <cmath>
+#include <vector>
+#include <iostream>
+#include <cstdlib>
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace nhfBoys {
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+
+// f[n] = F_n(x), n = 0 ~ maxN, and f[maxN+1] = exp(-x), from the series
+// and the downward recursion as the table of boysfun. It is more precise
+// than the Taylor table, whose error would limit the reachable tol.
+void reference(int maxN, double x, double *f) {
+    double ex = std::exp(-x);
+    f[maxN + 1] = ex;
+    f[maxN] = boysfun_series(maxN, x);
+    for (int n = maxN - 1; n >= 0; --n) {
+        f[n] = (2.0 * x * f[n+1] + ex) / (2 * n + 1);
+    }
+}
+
+}   // namespace (anonymous)
+
+BoysChebyshev::BoysChebyshev(double tol, int maxN)
+: tol(tol), maxErr(0.0), maxN(maxN), degree(0), nInterval(0), width(0.0), invWidth(0.0) {
+    for (int d = 1; d <= MAX_DEGREE; ++d) {
+        if (d < MAX_DEGREE && build(d, MAX_INTERVAL) > tol) continue;
+        for (int nInt = 1; nInt <= MAX_INTERVAL; nInt *= 2) {
+            maxErr = build(d, nInt);
+            if (maxErr <= tol) return;
+        }
+        break;
+    }
+    std::cerr << "BoysChebyshev cannot reach the relative error " << tol
+              << ", the best is " << maxErr << "!" << std::endl;
+    std::exit(-1);
+}
+
+double BoysChebyshev::build(int d, int nInt) {
+    degree = d;
+    nInterval = nInt;
+    width = TABLE_MAX_X / nInt;
+    invWidth = nInt / TABLE_MAX_X;
+
+    int nRow = maxN + 2;
+    std::size_t nc = std::size_t(d + 1);
+    coef.assign(std::size_t(nInt) * nRow * nc, 0.0);
+    expLeft.resize(nInt);
+
+    // c_k = 2/(d+1) sum_j f(t_j) T_k(t_j) on the Chebyshev nodes
+    // t_j = cos(theta_j), theta_j = pi (j+1/2) / (d+1), c_0 is halved.
+    // Row maxN+1 is exp(-(x - x_i)) of the interval, exp(-x) itself would
+    // lose x * eps of relative precision to the rounding of the nodes.
+    std::vector<double> f(nRow);
+    for (int i = 0; i < nInt; ++i) {
+        expLeft[i] = std::exp(-i * width);
+        double *c = &coef[std::size_t(i) * nRow * nc];
+        for (int j = 0; j <= d; ++j) {
+            double theta = PI * (j + 0.5) / (d + 1);
+            double dx = 0.5 * (std::cos(theta) + 1.0) * width;
+            reference(maxN, i * width + dx, f.data());
+            f[maxN + 1] = std::exp(-dx);
+            for (int n = 0; n < nRow; ++n) {
+            for (std::size_t k = 0; k < nc; ++k) {
+                c[n * nc + k] += 2.0 / (d + 1) * f[n] * std::cos(k * theta);
+            }}
+        }
+        for (int n = 0; n < nRow; ++n) {
+            c[n * nc] *= 0.5;
+        }
+    }
+
+    // the interpolation error peaks between the nodes, at the extrema
+    // t = cos(pi j / (d+1)) of T_(d+1)
+    double err = 0.0;
+    for (int i = 0; i < nInt; ++i) {
+        for (int j = 0; j <= d + 1; ++j) {
+            double x = i * width + 0.5 * (std::cos(PI * j / (d + 1)) + 1.0) * width;
+            x = std::min(x, TABLE_MAX_X);
+            reference(maxN, x, f.data());
+            for (int n = 0; n < nRow; ++n) {
+                double val = n <= maxN ? eval(n, x) : eval_exp(x);
+                err = std::max(err, std::fabs(val - f[n]) / f[n]);
+            }
+        }
+    }
+    return err;
+}
+
+double BoysChebyshev::clenshaw(int n, int i, double t) const {
+    const double *c = &coef[(std::size_t(i) * (maxN + 2) + n) * (degree + 1)];
+    double b1 = 0.0, b2 = 0.0;
+    for (int k = degree; k > 0; --k) {
+        double b0 = c[k] + 2.0 * t * b1 - b2;
+        b2 = b1;
+        b1 = b0;
+    }
+    return c[0] + t * b1 - b2;
+}
+
+double BoysChebyshev::eval(int n, double x) const {
+    // TABLE_MAX_X / nInterval is exact, so is the offset x - i * width
+    int i = std::min(int(x * invWidth), nInterval - 1);
+    return clenshaw(n, i, 2.0 * (x - i * width) * invWidth - 1.0);
+}
+
+double BoysChebyshev::eval_exp(double x) const {
+    int i = std::min(int(x * invWidth), nInterval - 1);
+    return expLeft[i] * clenshaw(maxN + 1, i, 2.0 * (x - i * width) * invWidth - 1.0);
+}
+
+double BoysChebyshev::operator()(int n, double x) const {
+    if (x > TABLE_MAX_X || n > maxN) return boysfun(n, x);
+    return eval(n, x);
+}
+
+void BoysChebyshev::all(int m, double x, double *fm) const {
+    all(m, &x, 1, fm);
+}
+
+void BoysChebyshev::all(int m, const double *x, std::size_t nx, double *fm) const {
+    if (m > maxN) {
+        boysfun_all(m, x, nx, fm);
+        return;
+    }
+
+    // as boysfun_all, with F_m and exp(-x) from the interpolation
+    const std::size_t CHUNK = 64;
+    double ex[CHUNK];
+    for (std::size_t i0 = 0; i0 < nx; i0 += CHUNK) {
+        std::size_t len = std::min(CHUNK, nx - i0);
+        const double *xc = x + i0;
+        double *top = fm + std::size_t(m) * nx + i0;
+        for (std::size_t i = 0; i < len; ++i) {
+            if (xc[i] > TABLE_MAX_X) {
+                top[i] = boysfun(m, xc[i]);
+                ex[i] = std::exp(-xc[i]);
+            } else {
+                top[i] = eval(m, xc[i]);
+                ex[i] = eval_exp(xc[i]);
+            }
+        }
+
+        for (int n = m - 1; n >= 0; --n) {
+            const double *up = fm + std::size_t(n + 1) * nx + i0;
+            double *cur = fm + std::size_t(n) * nx + i0;
+            for (std::size_t i = 0; i < len; ++i) {
+                cur[i] = (2.0 * xc[i] * up[i] + ex[i]) / (2 * n + 1);
+            }
+        }
+    }
+}
+
+const BoysChebyshev& boys_chebyshev(double tol) {
+    static std::map<double, std::unique_ptr<BoysChebyshev>> cache;
+    static std::mutex mtx;
+    std::lock_guard<std::mutex> lock(mtx);
+    std::unique_ptr<BoysChebyshev> &eval = cache[tol];
+    if (!eval) eval.reset(new BoysChebyshev(tol));
+    return *eval;
+}
+
+}   // namespace (nhfBoys)
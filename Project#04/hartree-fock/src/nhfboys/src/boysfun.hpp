@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+
+// Boys function F_n(x) = int_0^1 t^(2n) exp(-x t^2) dt
+//
+// 0 <= x <= 150: 8 term Taylor expansion around the nearest point of a
+//                table with step 0.1 and n = 0 ~ 40
+// x > 150:       F_n(x) = (2n-1)!! / 2^(n+1) sqrt(pi / x^(2n+1))
+//
+// n = 0 ~ MAX_N are covered by the table, larger n fall back to the
+// series expansion and are slow.
+namespace nhfBoys {
+
+const int    MAX_N = 32;
+
+const double TABLE_STEP  = 0.1;
+const double TABLE_MAX_X = 150.0;
+const int    TABLE_MAX_N = 40;      // MAX_N plus the Taylor derivatives
+const int    TAYLOR_TERMS = 8;
+
+double boysfun(int n, double x);
+
+// fm[n] = F_n(x), n = 0 ~ m. F_m comes from boysfun and the lower
+// orders from the downward recursion F_n = (2x F_n+1 + exp(-x)) / (2n+1),
+// so the whole vector costs one Taylor sum and one exp.
+void boysfun_all(int m, double x, double *fm);
+
+// the same for nx arguments at once, fm[n * nx + i] = F_n(x[i]). The
+// recursion runs over contiguous x, so the compiler can vectorize it,
+// and the results are the same as those of the scalar version.
+void boysfun_all(int m, const double *x, std::size_t nx, double *fm);
+
+// F_n(x) from the series, F_n(x) = exp(-x) sum_k (2x)^k / (2n+1)(2n+3)...(2n+2k+1),
+// used to build the table, accurate for every n but slow for large x
+double boysfun_series(int n, double x);
+
+
+// An evaluator of F_0(x) ~ F_m(x). The integral kernels take one as their
+// Boys policy, so that the accuracy can be traded for speed at run time.
+class BoysEvaluator {
+public:
+    virtual ~BoysEvaluator() {}
+
+    // fm[n] = F_n(x), n = 0 ~ m
+    virtual void all(int m, double x, double *fm) const = 0;
+
+    // fm[n * nx + i] = F_n(x[i]), n = 0 ~ m
+    virtual void all(int m, const double *x, std::size_t nx, double *fm) const = 0;
+};
+
+// boysfun_all, the Taylor table above
+class BoysTaylor : public BoysEvaluator {
+public:
+    void all(int m, double x, double *fm) const override
+    { boysfun_all(m, x, fm); }
+
+    void all(int m, const double *x, std::size_t nx, double *fm) const override
+    { boysfun_all(m, x, nx, fm); }
+};
+
+// the evaluator used when none is given
+const BoysEvaluator& boys_taylor();
+
+}   // namespace (nhfBoys)
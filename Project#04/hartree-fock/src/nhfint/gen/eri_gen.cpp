@@ -0,0 +1,363 @@
+// nhfint_gen writes one Head-Gordon-Pople kernel per (La Lb|Lc Ld) class,
+// together with a lookup table, see eri_gen.hpp for their interface.
+//
+//   usage: nhfint_gen <output dir> <max L>
+//
+// The recurrences are the ones of hgp_int.cpp, unrolled by walking them
+// backwards from the integrals that are needed. Every intermediate gets
+// its own variable the first time it is reached and is reused after
+// that, intermediates that no target depends on are never written.
+// The VRR works on VecD packs of ket primitive pairs, see simd.hpp.
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Cart {
+    int n[3];
+
+    int sum() const { return n[0] + n[1] + n[2]; }
+};
+
+// all components of angular momentum L, in generate_angmom order
+std::vector<Cart> cart_list(int L) {
+    std::vector<Cart> ret;
+    for (int i = 0; i <= L; ++i) {
+    for (int j = 0; j <= L - i; ++j) {
+        ret.push_back({{i, j, L - i - j}});
+    }}
+    return ret;
+}
+
+// the direction that hgp_int.cpp uses to build c from c - 1_dir
+int reduce_dir(const Cart &c)
+{ return c.n[0] > 0 ? 0 : (c.n[1] > 0 ? 1 : 2); }
+
+Cart shift(Cart c, int dir, int delta) {
+    c.n[dir] += delta;
+    return c;
+}
+
+std::string key(const Cart &c) {
+    std::ostringstream os;
+    os << c.n[0] << ',' << c.n[1] << ',' << c.n[2] << ';';
+    return os.str();
+}
+
+std::string str(int n) {
+    std::ostringstream os;
+    os << n;
+    return os.str();
+}
+
+// n * sym, without the factor when n == 1
+std::string times(int n, const std::string &sym)
+{ return n == 1 ? sym : str(n) + " * " + sym; }
+
+const char *XYZ[3] = {"x", "y", "z"};
+
+
+class KernelWriter {
+public:
+    KernelWriter(int La, int Lb, int Lc, int Ld)
+    : La(La), Lb(Lb), Lc(Lc), Ld(Ld), nVar(0),
+      useOo2z(false), useRoz(false), useOo2e(false), useRoe(false), useOo2ze(false) {
+        for (int dir = 0; dir < 3; ++dir) {
+            usePA[dir] = useWP[dir] = useQC[dir] = useWQ[dir] = false;
+            useAB[dir] = useCD[dir] = false;
+        }
+    }
+
+    static std::string name(int La, int Lb, int Lc, int Ld) {
+        return "eri_" + str(La) + "_" + str(Lb) + "_" + str(Lc) + "_" + str(Ld);
+    }
+
+    std::string write() {
+        // the targets, then the contracted [e0|f0] that they need
+        std::ostringstream store;
+        std::size_t idx = 0;
+        for (const Cart &a : cart_list(La)) {
+        for (const Cart &b : cart_list(Lb)) {
+        for (const Cart &c : cart_list(Lc)) {
+        for (const Cart &d : cart_list(Ld)) {
+            store << "    out[" << idx++ << "] = " << ket(a, b, c, d) << ";\n";
+        }}}}
+
+        std::ostringstream accum;
+        for (std::size_t i = 0; i < contrList.size(); ++i) {
+            const Contr &c = contrList[i];
+            accum << "            " << c.name << "v += " << vrr(c.e, c.f, 0) << ";\n";
+        }
+
+        // the ket loop runs over VecD::WIDTH primitive pairs at once, the
+        // lanes are summed up before the HRR
+        int M = La + Lb + Lc + Ld;
+        std::ostringstream os;
+        os << "void " << name(La, Lb, Lc, Ld) << "(const PairData &ab, const PairData &cd,\n"
+           << "        BoysFun boys, const void *boysCtx, double *out) {\n";
+        for (const Contr &c : contrList) {
+            os << "    VecD " << c.name << "v(0.0);\n";
+        }
+        os << "    VecD fm[" << M + 1 << "];\n\n"
+           << "    for (std::size_t i = 0; i < ab.nprim; ++i) {\n"
+           << "        const double zeta = ab.zeta[i];\n"
+           << "        const double Kab = ab.K[i];\n"
+           << "        const double Px = ab.Px[i], Py = ab.Py[i], Pz = ab.Pz[i];\n";
+        for (int dir = 0; dir < 3; ++dir) {
+            if (!usePA[dir]) continue;
+            os << "        const double PA" << XYZ[dir] << " = P" << XYZ[dir]
+               << " - ab.A[" << dir << "];\n";
+        }
+        if (useOo2z) os << "        const double oo2z = 0.5 / zeta;\n";
+
+        os << "        for (std::size_t j = 0; j < cd.nprim; j += VecD::WIDTH) {\n"
+           << "            const KetLanes q = ket_lanes(cd, j);\n"
+           << "            const VecD eta = q.zeta;\n"
+           << "            const VecD PQx = Px - q.Px, PQy = Py - q.Py, PQz = Pz - q.Pz;\n";
+        for (int dir = 0; dir < 3; ++dir) {
+            if (!useQC[dir]) continue;
+            os << "            const VecD QC" << XYZ[dir] << " = q.P" << XYZ[dir]
+               << " - cd.A[" << dir << "];\n";
+        }
+        os << "            const VecD ozpe = 1.0 / (zeta + eta);\n"
+           << "            const VecD rho = zeta * eta * ozpe;\n";
+        for (int dir = 0; dir < 3; ++dir) {
+            if (useWP[dir]) os << "            const VecD WP" << XYZ[dir]
+                               << " = -eta * ozpe * PQ" << XYZ[dir] << ";\n";
+            if (useWQ[dir]) os << "            const VecD WQ" << XYZ[dir]
+                               << " = zeta * ozpe * PQ" << XYZ[dir] << ";\n";
+        }
+        if (useRoz)   os << "            const VecD roz = rho / zeta;\n";
+        if (useOo2e)  os << "            const VecD oo2e = 0.5 / eta;\n";
+        if (useRoe)   os << "            const VecD roe = rho / eta;\n";
+        if (useOo2ze) os << "            const VecD oo2ze = 0.5 * ozpe;\n";
+        os << "            const VecD pre = PI25X2 * sqrt(ozpe) / (zeta * eta) * Kab * q.K;\n"
+           << "            boys_lanes(boys, boysCtx, " << M << ", rho * (PQx * PQx + PQy * PQy + PQz * PQz), pre, fm);\n\n"
+           << loop.str() << accum.str()
+           << "        }\n"
+           << "    }\n\n";
+        for (const Contr &c : contrList) {
+            os << "    const double " << c.name << " = hsum(" << c.name << "v);\n";
+        }
+        for (int dir = 0; dir < 3; ++dir) {
+            if (useAB[dir]) os << "    const double AB" << XYZ[dir] << " = ab.AB[" << dir << "];\n";
+            if (useCD[dir]) os << "    const double CD" << XYZ[dir] << " = cd.AB[" << dir << "];\n";
+        }
+        os << hrr.str() << store.str() << "}\n";
+        return os.str();
+    }
+
+private:
+    struct Contr {
+        std::string name;
+        Cart e, f;
+    };
+
+    int La, Lb, Lc, Ld;
+    int nVar;
+    std::ostringstream loop;    // inside the primitive quartet loop
+    std::ostringstream hrr;     // after the loops
+    std::map<std::string, std::string> vrrMap, contrMap, hrrMap;
+    std::vector<Contr> contrList;
+
+    bool usePA[3], useWP[3], useQC[3], useWQ[3], useAB[3], useCD[3];
+    bool useOo2z, useRoz, useOo2e, useRoe, useOo2ze;
+
+    std::string new_var(const char *prefix) { return prefix + str(nVar++); }
+
+    // [e0|f0]^(m) of one primitive quartet, already multiplied by pre
+    std::string vrr(const Cart &e, const Cart &f, int m) {
+        if (e.sum() == 0 && f.sum() == 0) return "fm[" + str(m) + "]";
+
+        std::string k = key(e) + key(f) + str(m);
+        auto it = vrrMap.find(k);
+        if (it != vrrMap.end()) return it->second;
+
+        std::string expr;
+        if (f.sum() == 0) {
+            // [a+1i,0|00]^(m) = PA_i [a0|00]^(m) + WP_i [a0|00]^(m+1)
+            //                 + a_i/2z ([a-1i,0|00]^(m) - rho/z [a-1i,0|00]^(m+1))
+            int dir = reduce_dir(e);
+            Cart e1 = shift(e, dir, -1);
+            usePA[dir] = useWP[dir] = true;
+            expr = std::string("PA") + XYZ[dir] + " * " + vrr(e1, f, m)
+                 + " + WP" + XYZ[dir] + " * " + vrr(e1, f, m + 1);
+            int na = e1.n[dir];
+            if (na > 0) {
+                Cart e2 = shift(e1, dir, -1);
+                useOo2z = useRoz = true;
+                expr += " + " + times(na, "oo2z") + " * (" + vrr(e2, f, m)
+                      + " - roz * " + vrr(e2, f, m + 1) + ")";
+            }
+        } else {
+            // [a0|c+1i,0]^(m) = QC_i [a0|c0]^(m) + WQ_i [a0|c0]^(m+1)
+            //                 + c_i/2e ([a0|c-1i,0]^(m) - rho/e [a0|c-1i,0]^(m+1))
+            //                 + a_i/2(z+e) [a-1i,0|c0]^(m+1)
+            int dir = reduce_dir(f);
+            Cart f1 = shift(f, dir, -1);
+            useQC[dir] = useWQ[dir] = true;
+            expr = std::string("QC") + XYZ[dir] + " * " + vrr(e, f1, m)
+                 + " + WQ" + XYZ[dir] + " * " + vrr(e, f1, m + 1);
+            int nc = f1.n[dir];
+            if (nc > 0) {
+                Cart f2 = shift(f1, dir, -1);
+                useOo2e = useRoe = true;
+                expr += " + " + times(nc, "oo2e") + " * (" + vrr(e, f2, m)
+                      + " - roe * " + vrr(e, f2, m + 1) + ")";
+            }
+            int na = e.n[dir];
+            if (na > 0) {
+                useOo2ze = true;
+                expr += " + " + times(na, "oo2ze") + " * " + vrr(shift(e, dir, -1), f1, m + 1);
+            }
+        }
+
+        std::string var = new_var("v");
+        loop << "            const VecD " << var << " = " << expr << ";\n";
+        vrrMap[k] = var;
+        return var;
+    }
+
+    // contracted [e0|f0]
+    std::string contr(const Cart &e, const Cart &f) {
+        std::string k = key(e) + key(f);
+        auto it = contrMap.find(k);
+        if (it != contrMap.end()) return it->second;
+
+        std::string var = new_var("c");
+        contrList.push_back({var, e, f});
+        contrMap[k] = var;
+        return var;
+    }
+
+    // (e,b| = (e+1i,b-1i| + AB_i (e,b-1i|, with ket component f
+    std::string bra(const Cart &e, const Cart &b, const Cart &f) {
+        if (b.sum() == 0) return contr(e, f);
+
+        std::string k = "b" + key(e) + key(b) + key(f);
+        auto it = hrrMap.find(k);
+        if (it != hrrMap.end()) return it->second;
+
+        int dir = reduce_dir(b);
+        Cart b1 = shift(b, dir, -1);
+        useAB[dir] = true;
+        std::string expr = bra(shift(e, dir, 1), b1, f)
+                         + " + AB" + XYZ[dir] + " * " + bra(e, b1, f);
+
+        std::string var = new_var("h");
+        hrr << "    const double " << var << " = " << expr << ";\n";
+        hrrMap[k] = var;
+        return var;
+    }
+
+    // |f,d) = |f+1i,d-1i) + CD_i |f,d-1i), with bra components a, b
+    std::string ket(const Cart &a, const Cart &b, const Cart &f, const Cart &d) {
+        if (d.sum() == 0) return bra(a, b, f);
+
+        std::string k = "k" + key(a) + key(b) + key(f) + key(d);
+        auto it = hrrMap.find(k);
+        if (it != hrrMap.end()) return it->second;
+
+        int dir = reduce_dir(d);
+        Cart d1 = shift(d, dir, -1);
+        useCD[dir] = true;
+        std::string expr = ket(a, b, shift(f, dir, 1), d1)
+                         + " + CD" + XYZ[dir] + " * " + ket(a, b, f, d1);
+
+        std::string var = new_var("h");
+        hrr << "    const double " << var << " = " << expr << ";\n";
+        hrrMap[k] = var;
+        return var;
+    }
+};
+
+
+const char *HEADER = "// generated by nhfint_gen, do not edit\n";
+
+// write text to path unless the file already holds it, so that an
+// unchanged kernel is not compiled again
+bool write_file(const std::string &path, const std::string &text) {
+    std::ifstream in(path.c_str());
+    if (in) {
+        std::ostringstream old;
+        old << in.rdbuf();
+        if (old.str() == text) return true;
+    }
+
+    std::ofstream out(path.c_str());
+    if (!out) {
+        std::cerr << "nhfint_gen: cannot write " << path << std::endl;
+        return false;
+    }
+    out << text;
+    return bool(out);
+}
+
+}   // namespace (anonymous)
+
+
+int main(int argc, char *argv[]) {
+    if (argc != 3) {
+        std::cerr << "usage: nhfint_gen <output dir> <max L>" << std::endl;
+        return 1;
+    }
+    std::string dir = argv[1];
+    int maxL = std::atoi(argv[2]);
+    if (maxL < 0 || maxL > 6) {
+        std::cerr << "nhfint_gen: max L must be in 0 ~ 6" << std::endl;
+        return 1;
+    }
+
+    std::ostringstream pi;
+    pi.precision(17);
+    pi << 2.0 * std::pow(std::acos(-1.0), 2.5);
+
+    std::ostringstream decl, table;
+    for (int La = 0; La <= maxL; ++La) {
+    for (int Lb = 0; Lb <= maxL; ++Lb) {
+    for (int Lc = 0; Lc <= maxL; ++Lc) {
+    for (int Ld = 0; Ld <= maxL; ++Ld) {
+        std::string name = KernelWriter::name(La, Lb, Lc, Ld);
+        std::ostringstream os;
+        os << HEADER
+           << "#include \"eri_gen.hpp\"\n"
+           << "#include \"simd.hpp\"\n"
+           << "#include <cmath>\n"
+           << "#include <cstddef>\n\n"
+           << "namespace nhfGen {\n\n"
+           << "namespace {\n"
+           << "const double PI25X2 = " << pi.str() << ";     // 2 pi^(5/2)\n"
+           << "}\n\n"
+           << KernelWriter(La, Lb, Lc, Ld).write()
+           << "\n}   // namespace (nhfGen)\n";
+        if (!write_file(dir + "/" + name + ".cpp", os.str())) return 1;
+
+        decl << "void " << name << "(const PairData &ab, const PairData &cd,\n"
+             << "        BoysFun boys, const void *boysCtx, double *out);\n";
+        table << "        " << name << ",\n";
+    }}}}
+
+    std::ostringstream os;
+    os << HEADER
+       << "#include \"eri_gen.hpp\"\n\n"
+       << "namespace nhfGen {\n\n"
+       << decl.str() << "\n"
+       << "const int MAX_L = " << maxL << ";\n\n"
+       << "Kernel kernel(int La, int Lb, int Lc, int Ld) {\n"
+       << "    static const Kernel table[] = {\n" << table.str() << "    };\n\n"
+       << "    if (La < 0 || Lb < 0 || Lc < 0 || Ld < 0 ||\n"
+       << "        La > MAX_L || Lb > MAX_L || Lc > MAX_L || Ld > MAX_L) return nullptr;\n"
+       << "    const int n = MAX_L + 1;\n"
+       << "    return table[((La * n + Lb) * n + Lc) * n + Ld];\n"
+       << "}\n\n"
+       << "}   // namespace (nhfGen)\n";
+    if (!write_file(dir + "/eri_gen_table.cpp", os.str())) return 1;
+
+    return 0;
+}
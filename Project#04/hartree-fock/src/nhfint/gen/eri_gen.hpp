@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+
+// Interface of the ERI kernels written by nhfint_gen. The kernels only
+// see plain arrays, so this library does not depend on nhfint.
+namespace nhfGen {
+
+// the primitive pairs of one shell pair (ab|, every array has nprim values
+struct PairData {
+    std::size_t   nprim;
+    const double *zeta;         // alpha_a + alpha_b
+    const double *Px, *Py, *Pz; // gaussian product centre
+    const double *K;            // exp(-ab/zeta |AB|^2) * coeff_a * coeff_b
+    double        A[3];         // centre of a
+    double        AB[3];        // A - B
+};
+
+// fm[m * nT + i] = F_m(T[i]), m = 0 ~ mmax, for the Boys evaluator ctx
+// the caller passed to the kernel
+typedef void (*BoysFun)(const void *ctx, int mmax, const double *T,
+                        std::size_t nT, double *fm);
+
+// (ab|cd) of one class, out is stored as [a][b][c][d] over the Cartesian
+// components in generate_angmom order, the component norms are not applied
+typedef void (*Kernel)(const PairData &ab, const PairData &cd,
+                       BoysFun boys, const void *boysCtx, double *out);
+
+// largest shell angular momentum with a generated kernel
+extern const int MAX_L;
+
+// the kernel of (La Lb|Lc Ld), nullptr when it was not generated
+Kernel kernel(int La, int Lb, int Lc, int Ld);
+
+}   // namespace (nhfGen)
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "eri_gen.hpp"
+#include <cstddef>
+#include <cmath>
+#if defined(__AVX512F__) || defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// A pack of doubles for the generated kernels, one primitive quartet per
+// lane. The width follows the instruction set the kernels are compiled
+// for: 8 with AVX-512, 4 with AVX2, 2 with SSE2 and 1 otherwise.
+namespace nhfGen {
+
+#if defined(__AVX512F__)
+
+struct VecD {
+    static const int WIDTH = 8;
+    __m512d v;
+
+    VecD() {}
+    VecD(double x): v(_mm512_set1_pd(x)) {}
+    explicit VecD(__m512d v): v(v) {}
+
+    static VecD load(const double *p) { return VecD(_mm512_loadu_pd(p)); }
+    void store(double *p) const { _mm512_storeu_pd(p, v); }
+};
+
+inline VecD operator+(VecD a, VecD b) { return VecD(_mm512_add_pd(a.v, b.v)); }
+inline VecD operator-(VecD a, VecD b) { return VecD(_mm512_sub_pd(a.v, b.v)); }
+inline VecD operator*(VecD a, VecD b) { return VecD(_mm512_mul_pd(a.v, b.v)); }
+inline VecD operator/(VecD a, VecD b) { return VecD(_mm512_div_pd(a.v, b.v)); }
+inline VecD sqrt(VecD a) { return VecD(_mm512_sqrt_pd(a.v)); }
+
+#elif defined(__AVX2__)
+
+struct VecD {
+    static const int WIDTH = 4;
+    __m256d v;
+
+    VecD() {}
+    VecD(double x): v(_mm256_set1_pd(x)) {}
+    explicit VecD(__m256d v): v(v) {}
+
+    static VecD load(const double *p) { return VecD(_mm256_loadu_pd(p)); }
+    void store(double *p) const { _mm256_storeu_pd(p, v); }
+};
+
+inline VecD operator+(VecD a, VecD b) { return VecD(_mm256_add_pd(a.v, b.v)); }
+inline VecD operator-(VecD a, VecD b) { return VecD(_mm256_sub_pd(a.v, b.v)); }
+inline VecD operator*(VecD a, VecD b) { return VecD(_mm256_mul_pd(a.v, b.v)); }
+inline VecD operator/(VecD a, VecD b) { return VecD(_mm256_div_pd(a.v, b.v)); }
+inline VecD sqrt(VecD a) { return VecD(_mm256_sqrt_pd(a.v)); }
+
+#elif defined(__SSE2__)
+
+struct VecD {
+    static const int WIDTH = 2;
+    __m128d v;
+
+    VecD() {}
+    VecD(double x): v(_mm_set1_pd(x)) {}
+    explicit VecD(__m128d v): v(v) {}
+
+    static VecD load(const double *p) { return VecD(_mm_loadu_pd(p)); }
+    void store(double *p) const { _mm_storeu_pd(p, v); }
+};
+
+inline VecD operator+(VecD a, VecD b) { return VecD(_mm_add_pd(a.v, b.v)); }
+inline VecD operator-(VecD a, VecD b) { return VecD(_mm_sub_pd(a.v, b.v)); }
+inline VecD operator*(VecD a, VecD b) { return VecD(_mm_mul_pd(a.v, b.v)); }
+inline VecD operator/(VecD a, VecD b) { return VecD(_mm_div_pd(a.v, b.v)); }
+inline VecD sqrt(VecD a) { return VecD(_mm_sqrt_pd(a.v)); }
+
+#else
+
+struct VecD {
+    static const int WIDTH = 1;
+    double v;
+
+    VecD() {}
+    VecD(double x): v(x) {}
+
+    static VecD load(const double *p) { return VecD(*p); }
+    void store(double *p) const { *p = v; }
+};
+
+inline VecD operator+(VecD a, VecD b) { return VecD(a.v + b.v); }
+inline VecD operator-(VecD a, VecD b) { return VecD(a.v - b.v); }
+inline VecD operator*(VecD a, VecD b) { return VecD(a.v * b.v); }
+inline VecD operator/(VecD a, VecD b) { return VecD(a.v / b.v); }
+inline VecD sqrt(VecD a) { return VecD(std::sqrt(a.v)); }
+
+#endif
+
+inline VecD  operator-(VecD a) { return VecD(0.0) - a; }
+inline VecD& operator+=(VecD &a, VecD b) { return a = a + b; }
+
+// sum of the lanes, in lane order
+inline double hsum(VecD a) {
+    double lane[VecD::WIDTH];
+    a.store(lane);
+    double ret = 0.0;
+    for (int i = 0; i < VecD::WIDTH; ++i) {
+        ret += lane[i];
+    }
+    return ret;
+}
+
+
+// ket primitive pairs j ~ j+WIDTH-1 of cd, one per lane. Lanes past
+// cd.nprim get K = 0 and zeta = 1, so they add nothing.
+struct KetLanes {
+    VecD zeta, Px, Py, Pz, K;
+};
+
+inline KetLanes ket_lanes(const PairData &cd, std::size_t j) {
+    const int W = VecD::WIDTH;
+    KetLanes ret;
+    if (j + W <= cd.nprim) {
+        ret.zeta = VecD::load(cd.zeta + j);
+        ret.Px = VecD::load(cd.Px + j);
+        ret.Py = VecD::load(cd.Py + j);
+        ret.Pz = VecD::load(cd.Pz + j);
+        ret.K = VecD::load(cd.K + j);
+        return ret;
+    }
+
+    double zeta[W], Px[W], Py[W], Pz[W], K[W];
+    for (int l = 0; l < W; ++l) {
+        bool in = j + l < cd.nprim;
+        zeta[l] = in ? cd.zeta[j + l] : 1.0;
+        Px[l] = in ? cd.Px[j + l] : 0.0;
+        Py[l] = in ? cd.Py[j + l] : 0.0;
+        Pz[l] = in ? cd.Pz[j + l] : 0.0;
+        K[l] = in ? cd.K[j + l] : 0.0;
+    }
+    ret.zeta = VecD::load(zeta);
+    ret.Px = VecD::load(Px);
+    ret.Py = VecD::load(Py);
+    ret.Pz = VecD::load(Pz);
+    ret.K = VecD::load(K);
+    return ret;
+}
+
+// fm[m] = pre * F_m(T), m = 0 ~ mmax, all lanes in one call of boys
+inline void boys_lanes(BoysFun boys, const void *ctx, int mmax,
+                       VecD T, VecD pre, VecD *fm) {
+    const int W = VecD::WIDTH;
+    double t[W], f[32 * W];
+    T.store(t);
+    boys(ctx, mmax, t, W, f);
+    for (int m = 0; m <= mmax; ++m) {
+        fm[m] = pre * VecD::load(f + m * W);
+    }
+}
+
+}   // namespace (nhfGen)
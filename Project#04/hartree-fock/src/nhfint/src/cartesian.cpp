@@ -0,0 +1,24 @@
+#include "cartesian.hpp"
+#include <vector>
+#include <cassert>
+
+namespace nhfInt {
+
+static std::vector<std::vector<AngMom>> build_cart_table() {
+    std::vector<std::vector<AngMom>> table(MAX_CART_ANG + 1);
+    for (int n = 0; n <= MAX_CART_ANG; ++n) {
+        for (int i = 0; i <= n; ++i) {
+        for (int j = 0; j <= n - i; ++j) {
+            table[n].push_back(AngMom(i, j, n - i - j));
+        }}
+    }
+    return table;
+}
+
+const std::vector<AngMom>& cart_list(int n) {
+    assert(n >= 0 && n <= MAX_CART_ANG);
+    static const std::vector<std::vector<AngMom>> table = build_cart_table();
+    return table[n];
+}
+
+}   // namespace (nhfInt)
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "tho_basis.hpp"
+#include "eri_class.hpp"
+#include <vector>
+#include <cstddef>
+
+namespace nhfInt {
+
+using tho::AngMom;
+
+// largest total angular momentum of the intermediates built by the
+// ERI engines, (ii|ii) needs 4 * 6
+const int MAX_CART_ANG = 24;
+
+// all ijk with i+j+k == n, in the order of generate_angmom(n),
+// unlike generate_angmom the list is built once and n may exceed 6
+const std::vector<AngMom>& cart_list(int n);
+
+// component of ijk in direction dir, dir: 0 x, 1 y, 2 z
+inline int ang_comp(const AngMom &m, int dir)
+{ return dir == 0 ? m.i : (dir == 1 ? m.j : m.k); }
+
+// the direction that the recurrences use to build m from m - 1_dir
+inline int reduce_dir(const AngMom &m)
+{ return m.i > 0 ? 0 : (m.j > 0 ? 1 : 2); }
+
+// index of m - 1_dir in cart_list(m.sum() - 1)
+inline std::size_t index_minus(const AngMom &m, int dir)
+{ return index_of_ijk(m.i - (dir == 0), m.j - (dir == 1), m.k - (dir == 2)); }
+
+// index of m + 1_dir in cart_list(m.sum() + 1)
+inline std::size_t index_plus(const AngMom &m, int dir)
+{ return index_of_ijk(m.i + (dir == 0), m.j + (dir == 1), m.k + (dir == 2)); }
+
+}   // namespace (nhfInt)
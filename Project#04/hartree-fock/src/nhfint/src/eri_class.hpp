@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+namespace nhfInt {
+
+// index of the Cartesian component (i,j,k) inside its shell,
+// components are ordered as generate_angmom(i+j+k) does
+inline std::size_t index_of_ijk(std::size_t i, std::size_t j, std::size_t k) {
+    std::size_t n = i + j + k;
+    return (2*n - i + 3) * i / 2 + j;
+}
+
+// number of Cartesian components of a shell with angular momentum n
+inline std::size_t num_cart(std::size_t n) {
+    return (n+1) * (n+2) / 2;
+}
+
+
+// All eri of one shell quartet (ab|cd).
+// eriVal is stored as a row-major 4-index array.
+class EriClass {
+public:
+    std::size_t angA, angB, angC, angD;     // Angular Momentum
+    std::size_t nbsA, nbsB, nbsC, nbsD;     // number of basis: nbsA = (angA+1)*(angA+2)/2
+    std::size_t num2, num3, num4;           // used in operator()
+    std::vector<double> eriVal;             // record eri
+
+    EriClass()
+    : angA(0), angB(0), angC(0), angD(0),
+      nbsA(1), nbsB(1), nbsC(1), nbsD(1),
+      num2(1), num3(1), num4(1),
+      eriVal(std::vector<double>(1, 0.0)) {}
+
+    EriClass(std::size_t na, std::size_t nb,
+             std::size_t nc, std::size_t nd )
+    : angA(na), angB(nb), angC(nc), angD(nd),
+      nbsA(num_cart(na)), nbsB(num_cart(nb)),
+      nbsC(num_cart(nc)), nbsD(num_cart(nd)),
+      num2(nbsB*nbsC*nbsD), num3(nbsC*nbsD), num4(nbsD),
+      eriVal(std::vector<double>(nbsA*nbsB*nbsC*nbsD, 0.0)) {}
+
+    // reshape to another class and zero it, the storage is
+    // reused so that a loop over quartets does not reallocate
+    void reset(std::size_t na, std::size_t nb,
+               std::size_t nc, std::size_t nd) {
+        angA = na; angB = nb; angC = nc; angD = nd;
+        nbsA = num_cart(na); nbsB = num_cart(nb);
+        nbsC = num_cart(nc); nbsD = num_cart(nd);
+        num2 = nbsB*nbsC*nbsD; num3 = nbsC*nbsD; num4 = nbsD;
+        eriVal.assign(nbsA*nbsB*nbsC*nbsD, 0.0);
+    }
+
+    // access single eri, must use operator()
+    // don't use operator[], c++ allow one arguement in []
+    // operator[i,j,k,l] is the same as operator[l]
+    double  operator()(std::size_t i, std::size_t j,
+                       std::size_t k, std::size_t l) const
+    { return eriVal[i*num2 + j*num3 + k*num4 + l]; }
+
+    double& operator()(std::size_t i, std::size_t j,
+                       std::size_t k, std::size_t l)
+    { return eriVal[i*num2 + j*num3 + k*num4 + l]; }
+
+    std::size_t size() const { return eriVal.size(); }
+};
+
+}   // namespace (nhfInt)
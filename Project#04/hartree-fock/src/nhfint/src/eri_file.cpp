@@ -0,0 +1,242 @@
+#include "eri_file.hpp"
+#include "fock.hpp"
+#include "scheduler.hpp"
+#include <vector>
+#include <string>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+#include <cstdlib>
+#include <cassert>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace nhfInt {
+
+using nhfMath::Matrix;
+
+static const char ERI_FILE_MAGIC[8] = {'N', 'H', 'F', 'E', 'R', 'I', '0', '1'};
+
+// block bk lies between the header and the index at indexOffset, on a
+// double boundary, and its functions are among the nFunc of the file
+static bool valid_block(const EriBlockInfo &bk, std::uint64_t nFunc, std::uint64_t indexOffset) {
+    if (bk.offset < sizeof(EriFileHeader) || bk.offset > indexOffset ||
+        bk.offset % sizeof(double) != 0) {
+        return false;
+    }
+    // the product of nfunc is checked factor by factor against the room
+    // left before the index, so that it cannot overflow
+    std::uint64_t room = (indexOffset - bk.offset) / sizeof(double), size = 1;
+    for (int x = 0; x < 4; ++x) {
+        if (bk.func[x] > nFunc || bk.nfunc[x] > nFunc - bk.func[x]) return false;
+        if (bk.nfunc[x] != 0 && size > room / bk.nfunc[x]) return false;
+        size *= bk.nfunc[x];
+    }
+    return true;
+}
+
+static void write_or_die(std::FILE *file, const void *p, std::size_t n) {
+    if (n > 0 && std::fwrite(p, n, 1, file) != 1) {
+        std::cerr << "Cannot write the ERI file!" << std::endl;
+        std::exit(-1);
+    }
+}
+
+
+/* EriFileWriter */
+EriFileWriter::EriFileWriter(const std::string &fileName, std::size_t nFunc)
+: file(std::fopen(fileName.c_str(), "wb")), header(), pos(sizeof(EriFileHeader)),
+  done(false) {
+    if (file == nullptr) {
+        std::cerr << "Cannot open " << fileName << " for writing!" << std::endl;
+        std::exit(-1);
+    }
+
+    // the blocks start behind the header, which is written again by close()
+    std::memcpy(header.magic, ERI_FILE_MAGIC, sizeof(header.magic));
+    header.nFunc = nFunc;
+    write_or_die(file, &header, sizeof(header));
+
+    thread = std::thread(&EriFileWriter::run, this);
+}
+
+EriFileWriter::~EriFileWriter() {
+    close();
+}
+
+void EriFileWriter::submit(std::vector<EriBlockInfo> &info, std::vector<double> &val) {
+    std::unique_lock<std::mutex> lock(mtx);
+    assert(!done);
+    cv.wait(lock, [this]() { return queue.size() < MAX_PENDING; });
+    queue.push_back(Buffer());
+    queue.back().info.swap(info);
+    queue.back().val.swap(val);
+    cv.notify_all();
+}
+
+void EriFileWriter::run() {
+    for (;;) {
+        Buffer buf;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [this]() { return done || !queue.empty(); });
+            if (queue.empty()) return;
+            buf.info.swap(queue.front().info);
+            buf.val.swap(queue.front().val);
+            queue.pop_front();
+            cv.notify_all();
+        }
+
+        // only this thread touches pos and index until close() joins it
+        write_or_die(file, buf.val.data(), buf.val.size() * sizeof(double));
+        for (EriBlockInfo &bk : buf.info) {
+            bk.offset = pos;
+            pos += bk.size() * sizeof(double);
+            index.push_back(bk);
+        }
+    }
+}
+
+void EriFileWriter::close() {
+    if (!thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        done = true;
+        cv.notify_all();
+    }
+    thread.join();
+
+    header.nBlock = index.size();
+    header.indexOffset = pos;
+    write_or_die(file, index.data(), index.size() * sizeof(EriBlockInfo));
+    if (std::fseek(file, 0, SEEK_SET) != 0) {
+        std::cerr << "Cannot write the ERI file!" << std::endl;
+        std::exit(-1);
+    }
+    write_or_die(file, &header, sizeof(header));
+    std::fclose(file);
+    file = nullptr;
+}
+
+
+/* EriFile */
+EriFile::EriFile(const std::string &fileName)
+: data(nullptr), length(0), header(), index(nullptr) {
+#ifndef _WIN32
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd >= 0 && ::fstat(fd, &st) == 0 && st.st_size > 0) {
+        length = std::size_t(st.st_size);
+        void *p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            ::madvise(p, length, MADV_SEQUENTIAL);
+            data = static_cast<const char*>(p);
+        }
+    }
+    if (fd >= 0) ::close(fd);
+#else
+    std::ifstream ifs(fileName, std::ios::binary);
+    copy.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    length = copy.size();
+    data = copy.empty() ? nullptr : copy.data();
+#endif
+
+    if (data == nullptr || length < sizeof(EriFileHeader)) {
+        std::cerr << "Cannot read the ERI file " << fileName << "!" << std::endl;
+        std::exit(-1);
+    }
+    // the index must fit behind indexOffset, nBlock is compared with the
+    // room there instead of multiplied, and every block must fit before it
+    std::memcpy(&header, data, sizeof(header));
+    bool valid = std::memcmp(header.magic, ERI_FILE_MAGIC, sizeof(header.magic)) == 0 &&
+                 header.indexOffset >= sizeof(EriFileHeader) &&
+                 header.indexOffset <= length &&
+                 header.indexOffset % sizeof(std::uint64_t) == 0 &&
+                 header.nBlock <= (length - header.indexOffset) / sizeof(EriBlockInfo);
+    if (valid) {
+        index = reinterpret_cast<const EriBlockInfo*>(data + header.indexOffset);
+        for (std::size_t k = 0; k < header.nBlock && valid; ++k) {
+            valid = valid_block(index[k], header.nFunc, header.indexOffset);
+        }
+    }
+    if (!valid) {
+        std::cerr << fileName << " is not an ERI file!" << std::endl;
+        std::exit(-1);
+    }
+}
+
+EriFile::~EriFile() {
+#ifndef _WIN32
+    if (data != nullptr) ::munmap(const_cast<char*>(data), length);
+#endif
+}
+
+const double* EriFile::block(std::size_t k) const {
+    assert(k < n_block());
+    return reinterpret_cast<const double*>(data + index[k].offset);
+}
+
+namespace {
+
+// contracts blocks of an EriFile into the J and K of one thread
+struct FileJKWorker {
+    const EriFile *file;
+    JKBuilder      jk;
+
+    void operator()(std::size_t k) {
+        const EriBlockInfo &bk = file->info(k);
+        std::size_t func[4], nfunc[4];
+        for (int x = 0; x < 4; ++x) {
+            func[x] = bk.func[x];
+            nfunc[x] = bk.nfunc[x];
+        }
+        jk.add(func, nfunc, file->block(k));
+    }
+};
+
+}   // namespace (anonymous)
+
+void EriFile::jk(const Matrix &D, Matrix &J, Matrix &K) const {
+    std::size_t n = n_func();
+    assert(D.rows() == n && D.cols() == n);
+
+    std::vector<double> cost(n_block());
+    for (std::size_t k = 0; k < n_block(); ++k) {
+        cost[k] = double(index[k].size());
+    }
+
+    TaskPlan plan(cost, num_threads());
+    std::vector<FileJKWorker> worker(plan.n_thread(), FileJKWorker{this, JKBuilder(D)});
+    run_tasks(plan, worker);
+
+    J = Matrix(n, n, 0.0);
+    K = Matrix(n, n, 0.0);
+    for (const FileJKWorker &w : worker) {
+        w.jk.add_to(J, K);
+    }
+}
+
+EriTensor EriFile::tensor() const {
+    EriTensor ret(n_func());
+    double *out = ret.data();
+    for (std::size_t k = 0; k < n_block(); ++k) {
+        const EriBlockInfo &bk = index[k];
+        const double *v = block(k);
+        std::size_t nb = bk.nfunc[1], nc = bk.nfunc[2], nd = bk.nfunc[3];
+        for (std::size_t ia = 0; ia < bk.nfunc[0]; ++ia) {
+        for (std::size_t ib = 0; ib < nb; ++ib) {
+        for (std::size_t ic = 0; ic < nc; ++ic) {
+        for (std::size_t id = 0; id < nd; ++id) {
+            out[idx4(bk.func[0] + ia, bk.func[1] + ib,
+                     bk.func[2] + ic, bk.func[3] + id)] = v[((ia * nb + ib) * nc + ic) * nd + id];
+        }}}}
+    }
+    return ret;
+}
+
+}   // namespace (nhfInt)
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "matrix.hpp"
+#include "eri_tensor.hpp"
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+
+namespace nhfInt {
+
+// An ERI file holds the shell quartet blocks of BasisSet::write_eri_file
+// in the order they were computed, followed by their index:
+//
+//     EriFileHeader       32 bytes
+//     blocks              doubles, block k at index[k].offset
+//     index               nBlock EriBlockInfo at header.indexOffset
+//
+// A block is the (ab|cd) of four function ranges, func[x] ~ func[x] +
+// nfunc[x] - 1, in the layout of EriClass::eriVal after the transformation
+// of pure shells. Every element of mat_int_repulsion that was not screened
+// out is in exactly one block. Numbers are in the byte order of the
+// machine that wrote the file.
+struct EriFileHeader {
+    char          magic[8];     // "NHFERI01"
+    std::uint64_t nFunc;
+    std::uint64_t nBlock;
+    std::uint64_t indexOffset;  // bytes from the start of the file
+};
+
+struct EriBlockInfo {
+    std::uint64_t offset;       // bytes from the start of the file
+    std::uint32_t func[4];
+    std::uint32_t nfunc[4];
+
+    std::size_t size() const { return std::size_t(nfunc[0]) * nfunc[1] * nfunc[2] * nfunc[3]; }
+};
+
+
+// Appends blocks to an ERI file from a thread of its own, the threads
+// that compute the integrals only hand over filled buffers. Nothing is
+// readable before close().
+class EriFileWriter {
+public:
+    static const std::size_t MAX_PENDING = 8;   // buffers queued at most
+
+    EriFileWriter(const std::string &fileName, std::size_t nFunc);
+    ~EriFileWriter();
+
+    EriFileWriter(const EriFileWriter&) = delete;
+    EriFileWriter& operator=(const EriFileWriter&) = delete;
+
+    // val holds the blocks of info one after the other, the writer sets
+    // their offsets. Both are taken over and left empty. Waits while
+    // MAX_PENDING buffers are queued, so a slow disk holds back the
+    // integrals instead of piling them up in memory.
+    void submit(std::vector<EriBlockInfo> &info, std::vector<double> &val);
+
+    // waits for the queued buffers, then writes the index and the header
+    void close();
+
+private:
+    struct Buffer {
+        std::vector<EriBlockInfo> info;
+        std::vector<double>       val;
+    };
+
+    std::FILE                *file;
+    EriFileHeader             header;
+    std::uint64_t             pos;      // end of the blocks written so far
+    std::vector<EriBlockInfo> index;
+    std::deque<Buffer>        queue;
+    bool                      done;
+    std::mutex                mtx;
+    std::condition_variable   cv;
+    std::thread               thread;
+
+    void run();
+};
+
+
+// An ERI file mapped into memory for reading. The blocks are meant to be
+// read in file order, the kernel is told so and reads ahead.
+class EriFile {
+public:
+    explicit EriFile(const std::string &fileName);
+    ~EriFile();
+
+    EriFile(const EriFile&) = delete;
+    EriFile& operator=(const EriFile&) = delete;
+
+    std::size_t n_func()  const { return header.nFunc; }
+    std::size_t n_block() const { return header.nBlock; }
+
+    const EriBlockInfo& info(std::size_t k) const { return index[k]; }
+    const double*       block(std::size_t k) const;
+
+    // J and K of a symmetric density, as BasisSet::mat_jk, streaming the
+    // blocks once with consecutive runs of blocks on each thread
+    void jk(const nhfMath::Matrix &D, nhfMath::Matrix &J, nhfMath::Matrix &K) const;
+
+    // the integrals in the order of mat_int_repulsion
+    EriTensor tensor() const;
+
+private:
+    const char          *data;
+    std::size_t          length;
+    EriFileHeader        header;
+    const EriBlockInfo  *index;
+    std::vector<char>    copy;      // the file, where there is no mmap
+};
+
+}   // namespace (nhfInt)
@@ -0,0 +1,230 @@
+#include "eri_store.hpp"
+#include "fock.hpp"
+#include "scheduler.hpp"
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <cassert>
+
+namespace nhfInt {
+
+using nhfMath::Matrix;
+
+EriStore::EriStore(std::size_t nFunc, double absErr)
+: nFunc(nFunc), absErr(absErr), step(2.0 * absErr) {
+    assert(absErr > 0.0);
+}
+
+namespace {
+
+// integers of width bytes, in the byte order of the machine
+template <typename Int>
+void put_int(unsigned char *p, long long q) {
+    Int x = static_cast<Int>(q);
+    std::memcpy(p, &x, sizeof(Int));
+}
+
+template <typename Int>
+Int get_int(const unsigned char *p) {
+    Int q;
+    std::memcpy(&q, p, sizeof(Int));
+    return q;
+}
+
+// a stored value, integers are multiples of step
+template <typename Int>
+double get_value(const unsigned char *p, double step) {
+    return step * get_int<Int>(p);
+}
+
+template <>
+double get_value<double>(const unsigned char *p, double) {
+    return get_int<double>(p);
+}
+
+// the n values of a block, whose values of type Int follow the mask.
+// Most bytes of the mask are all zero or all one, they are written
+// without testing the bits one by one; the bits past n are 0, so only
+// a full byte can be all one.
+template <typename Int>
+void decode_values(const unsigned char *mask, std::size_t n, double step, double *v) {
+    const unsigned char *p = mask + (n + 7) / 8;
+    for (std::size_t e0 = 0; e0 < n; e0 += 8) {
+        unsigned m = mask[e0 / 8];
+        double *o = v + e0;
+        if (m == 0x00) {
+            std::size_t len = std::min(std::size_t(8), n - e0);
+            for (std::size_t b = 0; b < len; ++b) o[b] = 0.0;
+        } else if (m == 0xFF) {
+            for (std::size_t b = 0; b < 8; ++b) {
+                o[b] = get_value<Int>(p + b * sizeof(Int), step);
+            }
+            p += 8 * sizeof(Int);
+        } else {
+            std::size_t len = std::min(std::size_t(8), n - e0);
+            for (std::size_t b = 0; b < len; ++b) {
+                if (m & (1u << b)) {
+                    o[b] = get_value<Int>(p, step);
+                    p += sizeof(Int);
+                } else {
+                    o[b] = 0.0;
+                }
+            }
+        }
+    }
+}
+
+}   // namespace (anonymous)
+
+void EriStore::add(const std::size_t *func, const std::size_t *nfunc, const double *v) {
+    Block bk;
+    for (int x = 0; x < 4; ++x) {
+        assert(nfunc[x] < 256);
+        bk.func[x] = std::uint32_t(func[x]);
+        bk.nfunc[x] = std::uint8_t(nfunc[x]);
+    }
+    std::size_t n = bk.size();
+
+    // a value beyond the range of 4 byte integers keeps the block exact
+    const double MAX_INT32 = 2147483647.0;
+    quant.resize(n);
+    std::size_t nNonzero = 0;
+    bool exact = false;
+    long long maxQ = 0;
+    for (std::size_t e = 0; e < n; ++e) {
+        double r = v[e] / step;
+        if (std::fabs(r) > MAX_INT32) {
+            exact = true;
+            quant[e] = 1;
+        } else {
+            quant[e] = std::llround(r);
+        }
+    }
+
+    // the copies of a unique (ij|kl) inside the block, where a pair has
+    // the same shell twice or bra and ket are the same, are left out too
+    bool sameAB = func[0] == func[1], sameCD = func[2] == func[3];
+    bool sameBraKet = func[0] == func[2] && func[1] == func[3];
+    std::size_t nb = nfunc[1], nc = nfunc[2], nd = nfunc[3];
+    for (std::size_t e = 0; e < n; ++e) {
+        std::size_t id = e % nd, ic = e / nd % nc, ib = e / (nd * nc) % nb, ia = e / (nd * nc * nb);
+        if ((sameAB && ib > ia) || (sameCD && id > ic) ||
+            (sameBraKet && (ic > ia || (ic == ia && id > ib)))) {
+            quant[e] = 0;
+        }
+        if (quant[e] != 0) ++nNonzero;
+        maxQ = std::max(maxQ, quant[e] < 0 ? -quant[e] : quant[e]);
+    }
+    if (nNonzero == 0) return;
+
+    bk.width = exact ? 8 : maxQ <= 127 ? 1 : maxQ <= 32767 ? 2 : 4;
+    bk.offset = data.size();
+    std::size_t maskBytes = (n + 7) / 8;
+    data.resize(data.size() + maskBytes + nNonzero * bk.width, 0);
+
+    unsigned char *mask = &data[bk.offset];
+    unsigned char *p = mask + maskBytes;
+    for (std::size_t e = 0; e < n; ++e) {
+        if (quant[e] == 0) continue;
+        mask[e / 8] |= static_cast<unsigned char>(1u << (e % 8));
+        switch (bk.width) {
+        case 1: put_int<std::int8_t>(p, quant[e]);  break;
+        case 2: put_int<std::int16_t>(p, quant[e]); break;
+        case 4: put_int<std::int32_t>(p, quant[e]); break;
+        default: std::memcpy(p, &v[e], sizeof(double));
+        }
+        p += bk.width;
+    }
+    blocks.push_back(bk);
+}
+
+void EriStore::append(const EriStore &other) {
+    assert(other.nFunc == nFunc && other.absErr == absErr);
+    std::uint64_t shift = data.size();
+    data.insert(data.end(), other.data.begin(), other.data.end());
+    for (Block bk : other.blocks) {
+        bk.offset += shift;
+        blocks.push_back(bk);
+    }
+}
+
+void EriStore::decode(std::size_t k, double *v) const {
+    const Block &bk = blocks[k];
+    const unsigned char *mask = &data[bk.offset];
+    switch (bk.width) {
+    case 1: decode_values<std::int8_t>(mask, bk.size(), step, v);  break;
+    case 2: decode_values<std::int16_t>(mask, bk.size(), step, v); break;
+    case 4: decode_values<std::int32_t>(mask, bk.size(), step, v); break;
+    default: decode_values<double>(mask, bk.size(), step, v);
+    }
+}
+
+namespace {
+
+// decompresses blocks of an EriStore into the J and K of one thread
+struct StoreJKWorker {
+    const EriStore      *store;
+    JKBuilder            jk;
+    std::vector<double>  val;
+
+    void operator()(std::size_t k) {
+        const EriStore::Block &bk = store->block(k);
+        std::size_t func[4], nfunc[4];
+        for (int x = 0; x < 4; ++x) {
+            func[x] = bk.func[x];
+            nfunc[x] = bk.nfunc[x];
+        }
+        val.resize(bk.size());
+        store->decode(k, val.data());
+        jk.add(func, nfunc, val.data());
+    }
+};
+
+}   // namespace (anonymous)
+
+void EriStore::jk(const Matrix &D, Matrix &J, Matrix &K) const {
+    std::size_t n = nFunc;
+    assert(D.rows() == n && D.cols() == n);
+
+    std::vector<double> cost(n_block());
+    for (std::size_t k = 0; k < n_block(); ++k) {
+        cost[k] = double(blocks[k].size());
+    }
+
+    TaskPlan plan(cost, num_threads());
+    std::vector<StoreJKWorker> worker(plan.n_thread(), StoreJKWorker{this, JKBuilder(D), {}});
+    run_tasks(plan, worker);
+
+    J = Matrix(n, n, 0.0);
+    K = Matrix(n, n, 0.0);
+    for (const StoreJKWorker &w : worker) {
+        w.jk.add_to(J, K);
+    }
+}
+
+EriTensor EriStore::tensor() const {
+    EriTensor ret(nFunc);
+    double *out = ret.data();
+    std::vector<double> v;
+    for (std::size_t k = 0; k < n_block(); ++k) {
+        const Block &bk = blocks[k];
+        v.resize(bk.size());
+        decode(k, v.data());
+        std::size_t nb = bk.nfunc[1], nc = bk.nfunc[2], nd = bk.nfunc[3];
+        for (std::size_t ia = 0; ia < bk.nfunc[0]; ++ia) {
+        for (std::size_t ib = 0; ib < nb; ++ib) {
+        for (std::size_t ic = 0; ic < nc; ++ic) {
+        for (std::size_t id = 0; id < nd; ++id) {
+            // the copies that add() left out decode to 0
+            double val = v[((ia * nb + ib) * nc + ic) * nd + id];
+            if (val != 0.0) {
+                out[idx4(bk.func[0] + ia, bk.func[1] + ib,
+                         bk.func[2] + ic, bk.func[3] + id)] = val;
+            }
+        }}}}
+    }
+    return ret;
+}
+
+}   // namespace (nhfInt)
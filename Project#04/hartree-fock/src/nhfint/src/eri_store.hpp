@@ -0,0 +1,70 @@
+#pragma once
+
+#include "matrix.hpp"
+#include "eri_tensor.hpp"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace nhfInt {
+
+// The blocks of unique shell quartets in memory, compressed with a bound
+// absErr on the absolute error of every integral. A block is the (ab|cd)
+// of four function ranges in the layout of EriClass::eriVal, as for
+// EriFile. Each value is rounded to an integer multiple of 2 absErr, the
+// integers are stored in 1, 2 or 4 bytes, the fewest that hold the
+// largest one of the block, or the block keeps its doubles when even 4
+// bytes are too few. The values that round to 0 are only marked in a bit
+// mask of the block, as are the repeated copies of an integral inside
+// blocks such as (aa|bc) or (ab|ab), which decode to 0. Blocks with
+// nothing else are not stored at all. JKBuilder never reads the copies.
+class EriStore {
+public:
+    struct Block {
+        std::uint64_t offset;       // bytes into the data of the store
+        std::uint32_t func[4];
+        std::uint8_t  nfunc[4];
+        std::uint8_t  width;        // bytes of a value, 8 is a double
+
+        std::size_t size() const { return std::size_t(nfunc[0]) * nfunc[1] * nfunc[2] * nfunc[3]; }
+    };
+
+    EriStore(): nFunc(0), absErr(0.0), step(0.0) {}
+    EriStore(std::size_t nFunc, double absErr);
+
+    std::size_t n_func()  const { return nFunc; }
+    std::size_t n_block() const { return blocks.size(); }
+    double      abs_err() const { return absErr; }
+
+    // bytes of the compressed blocks and their labels
+    std::size_t bytes() const { return data.size() + blocks.size() * sizeof(Block); }
+
+    const Block& block(std::size_t k) const { return blocks[k]; }
+
+    // compresses one block, func and nfunc as in JKBuilder::add
+    void add(const std::size_t *func, const std::size_t *nfunc, const double *v);
+
+    // the blocks of other, which has the same n_func and abs_err, behind
+    // those of this store
+    void append(const EriStore &other);
+
+    // the values of block k into v, block(k).size() of them
+    void decode(std::size_t k, double *v) const;
+
+    // J and K of a symmetric density, as BasisSet::mat_jk, decompressing
+    // the blocks once with consecutive runs of blocks on each thread
+    void jk(const nhfMath::Matrix &D, nhfMath::Matrix &J, nhfMath::Matrix &K) const;
+
+    // the integrals in the order of mat_int_repulsion
+    EriTensor tensor() const;
+
+private:
+    std::size_t                nFunc;
+    double                     absErr;
+    double                     step;    // 2 absErr
+    std::vector<Block>         blocks;
+    std::vector<unsigned char> data;    // per block the bit mask, then the values
+    std::vector<long long>     quant;   // scratch of add
+};
+
+}   // namespace (nhfInt)
@@ -0,0 +1,122 @@
+#include "eri_tensor.hpp"
+#include "scheduler.hpp"
+#include <vector>
+#include <cassert>
+
+namespace nhfInt {
+
+using nhfMath::Matrix;
+
+EriTensor::EriTensor(std::size_t nFunc)
+: nFunc(nFunc), val(nFunc == 0 ? 0 : idx4(nFunc-1, nFunc-1, nFunc-1, nFunc-1) + 1, 0.0) {}
+
+EriTensor::EriTensor(std::size_t nFunc, const Matrix &eri)
+: EriTensor(nFunc) {
+    assert(eri.size() == val.size());
+    for (std::size_t x = 0; x < val.size(); ++x) {
+        val[x] = eri(x);
+    }
+}
+
+namespace {
+
+// J' and K' of the rows of one thread, with the weights of JKBuilder:
+// every (ij|kl) is added once to J'_ij, J'_kl and K'_ik, K'_jl, K'_il,
+// K'_jk times the number of its permutations.
+struct JKRows {
+    const EriTensor                *eri;
+    const std::vector<std::size_t> *rowI, *rowJ;
+    const double                   *D;
+    std::size_t                     n;
+    std::vector<double>             J, K, w;
+
+    void operator()(std::size_t ij) {
+        std::size_t i = (*rowI)[ij], j = (*rowJ)[ij];
+
+        // the row times its weights, 8 for distinct i > j, k > l, ij > kl,
+        // halved for each of i == j, k == l and ij == kl
+        const double *v = eri->row(ij);
+        double deg = i == j ? 4.0 : 8.0;
+        w.assign(v, v + ij + 1);
+        for (std::size_t kl = 0; kl <= ij; ++kl) {
+            w[kl] *= deg;
+        }
+        for (std::size_t k = 0; k * (k + 1) / 2 + k <= ij; ++k) {
+            w[k * (k + 1) / 2 + k] *= 0.5;
+        }
+        w[ij] *= 0.5;
+
+        // the kl of row ij are k = 0 ~ i with l = 0 ~ k, the last k = i
+        // only up to l = j, so every inner loop runs over one row of D,
+        // J' and K'
+        const double *Di = D + i * n, *Dj = D + j * n;
+        double *Ki = &K[i * n], *Kj = &K[j * n];
+        double dij = Di[j], jij = 0.0;
+        const double *wk = w.data();
+        for (std::size_t k = 0; k <= i; ++k) {
+            std::size_t nl = (k == i ? j : k) + 1;
+            const double *Dk = D + k * n;
+            double *Jk = &J[k * n];
+            double dik = Di[k], djk = Dj[k];
+            double sJ = 0.0, sKi = 0.0, sKj = 0.0;
+            for (std::size_t l = 0; l < nl; ++l) {
+                double x = wk[l];
+                sJ  += Dk[l] * x;
+                Jk[l] += dij * x;
+                sKi += Dj[l] * x;
+                Kj[l] += dik * x;
+                Ki[l] += djk * x;
+                sKj += Di[l] * x;
+            }
+            jij += sJ;
+            Ki[k] += sKi;
+            Kj[k] += sKj;
+            wk += nl;
+        }
+        J[i * n + j] += jij;
+    }
+};
+
+}   // namespace (anonymous)
+
+void EriTensor::jk(const Matrix &D, Matrix &J, Matrix &K) const {
+    std::size_t n = nFunc;
+    assert(D.rows() == n && D.cols() == n);
+
+    std::size_t nPair = n * (n + 1) / 2;
+    std::vector<std::size_t> rowI, rowJ;
+    std::vector<double> cost;
+    rowI.reserve(nPair);
+    rowJ.reserve(nPair);
+    cost.reserve(nPair);
+    for (std::size_t i = 0; i < n; ++i) {
+    for (std::size_t j = 0; j <= i; ++j) {
+        rowI.push_back(i);
+        rowJ.push_back(j);
+        cost.push_back(double(rowI.size()));
+    }}
+    assert(rowI.size() == nPair);
+
+    std::vector<double> dense(n * n);
+    for (std::size_t x = 0; x < n * n; ++x) {
+        dense[x] = D(x / n, x % n);
+    }
+
+    TaskPlan plan(cost, num_threads());
+    JKRows proto = {this, &rowI, &rowJ, dense.data(), n,
+                    std::vector<double>(n * n, 0.0), std::vector<double>(n * n, 0.0), {}};
+    std::vector<JKRows> worker(plan.n_thread(), proto);
+    run_tasks(plan, worker);
+
+    J = Matrix(n, n, 0.0);
+    K = Matrix(n, n, 0.0);
+    for (const JKRows &w : worker) {
+        for (std::size_t i = 0; i < n; ++i) {
+        for (std::size_t j = 0; j < n; ++j) {
+            J(i,j) += 0.25 * (w.J[i * n + j] + w.J[j * n + i]);
+            K(i,j) += 0.125 * (w.K[i * n + j] + w.K[j * n + i]);
+        }}
+    }
+}
+
+}   // namespace (nhfInt)
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "matrix.hpp"
+#include <vector>
+#include <cstddef>
+
+namespace nhfInt {
+
+// When we use a one-dimensional array to store a symmetric matrix, 
+// idx2 calculates the position of the matrix element in the array.
+inline std::size_t idx2(std::size_t i, std::size_t j)
+{ return  i>j ? i * (i+1) / 2 + j : j * (j+1) / 2 + i; }
+
+inline std::size_t idx4(std::size_t i, std::size_t j, 
+                        std::size_t k, std::size_t l)
+{ return  idx2(idx2(i,j), idx2(k,l)); }
+
+
+// The unique (ij|kl) of nFunc functions in the order of idx4, the same
+// as BasisSet::mat_int_repulsion. The pair ij >= kl is the major index,
+// so row ij, the (ij|kl) of kl = 0 ~ ij, is contiguous and the rows
+// follow each other: jk() walks the whole array once from the start.
+class EriTensor {
+public:
+    EriTensor(): nFunc(0) {}
+    explicit EriTensor(std::size_t nFunc);
+
+    // the integrals of mat_int_repulsion over nFunc functions
+    EriTensor(std::size_t nFunc, const nhfMath::Matrix &eri);
+
+    std::size_t n_func() const { return nFunc; }
+    std::size_t size()   const { return val.size(); }
+
+    double  operator()(std::size_t i, std::size_t j, std::size_t k, std::size_t l) const
+    { return val[idx4(i, j, k, l)]; }
+    double& operator()(std::size_t i, std::size_t j, std::size_t k, std::size_t l)
+    { return val[idx4(i, j, k, l)]; }
+
+    // row ij of the pair ij = idx2(i,j)
+    const double* row(std::size_t ij) const { return val.data() + ij * (ij + 1) / 2; }
+
+    double*       data()       { return val.data(); }
+    const double* data() const { return val.data(); }
+
+    // J_ab = sum_cd (ab|cd) D_cd and K_ab = sum_cd (ac|bd) D_cd of a
+    // symmetric density, with the rows spread over the threads
+    void jk(const nhfMath::Matrix &D, nhfMath::Matrix &J, nhfMath::Matrix &K) const;
+
+private:
+    std::size_t         nFunc;
+    std::vector<double> val;
+};
+
+}   // namespace (nhfInt)
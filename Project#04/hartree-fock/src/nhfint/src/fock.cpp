@@ -0,0 +1,69 @@
+#include "fock.hpp"
+#include <cassert>
+
+namespace nhfInt {
+
+using nhfMath::Matrix;
+
+JKBuilder::JKBuilder(const Matrix &D)
+: D(&D), n(D.rows()), Jp(n * n, 0.0), Kp(n * n, 0.0) {
+    assert(D.cols() == n);
+}
+
+void JKBuilder::add(const std::size_t *func, const std::size_t *nfunc, const double *v) {
+    const Matrix &Dm = *D;
+    std::size_t fa = func[0], fb = func[1], fc = func[2], fd = func[3];
+    std::size_t nb = nfunc[1], nc = nfunc[2], nd = nfunc[3];
+    bool sameAB = fa == fb, sameCD = fc == fd;
+    bool sameBraKet = fa == fc && fb == fd;
+    for (std::size_t ia = 0; ia < nfunc[0]; ++ia) {
+    for (std::size_t ib = 0; ib < (sameAB ? ia + 1 : nb); ++ib) {
+        std::size_t i = fa + ia, j = fb + ib;
+        double dij = Dm(i,j);
+        double degIJ = i == j ? 1.0 : 2.0;
+    for (std::size_t ic = 0; ic < (sameBraKet ? ia + 1 : nc); ++ic) {
+    for (std::size_t id = 0; id < (sameCD ? ic + 1 : nd); ++id) {
+        std::size_t k = fc + ic, l = fd + id;
+        if (sameBraKet && k == i && l > j) break;
+        double deg = degIJ * (k == l ? 1.0 : 2.0) * (k == i && l == j ? 1.0 : 2.0);
+        double val = deg * v[((ia * nb + ib) * nc + ic) * nd + id];
+        Jp[i * n + j] += Dm(k,l) * val;
+        Jp[k * n + l] += dij * val;
+        Kp[i * n + k] += Dm(j,l) * val;
+        Kp[j * n + l] += Dm(i,k) * val;
+        Kp[i * n + l] += Dm(j,k) * val;
+        Kp[j * n + k] += Dm(i,l) * val;
+    }}}}
+}
+
+void JKBuilder::add_to(Matrix &J, Matrix &K) const {
+    assert(J.rows() == n && K.rows() == n);
+    for (std::size_t i = 0; i < n; ++i) {
+    for (std::size_t j = 0; j < n; ++j) {
+        J(i,j) += 0.25 * (Jp[i * n + j] + Jp[j * n + i]);
+        K(i,j) += 0.125 * (Kp[i * n + j] + Kp[j * n + i]);
+    }}
+}
+
+IncrementalJK::IncrementalJK(const tho::BasisSet &bsSet, const EriOption &opt,
+                             int rebuildEvery)
+: full(false), rebuildEvery(rebuildEvery), bsSet(&bsSet), opt(opt), nIncrement(-1) {}
+
+void IncrementalJK::update(const Matrix &D) {
+    assert(D.rows() == bsSet->n_func() && D.cols() == bsSet->n_func());
+
+    full = nIncrement < 0 || (rebuildEvery > 0 && nIncrement + 1 >= rebuildEvery);
+    if (full) {
+        bsSet->mat_jk(D, J, K, opt, &stat);
+        nIncrement = 0;
+    } else {
+        Matrix dJ, dK;
+        bsSet->mat_jk(D - lastD, dJ, dK, opt, &stat);
+        J += dJ;
+        K += dK;
+        ++nIncrement;
+    }
+    lastD = D;
+}
+
+}   // namespace (nhfInt)
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "tho_basis.hpp"
+#include "matrix.hpp"
+#include <vector>
+#include <cstddef>
+
+namespace nhfInt {
+
+// J_ab = sum_cd (ab|cd) D_cd and K_ab = sum_cd (ac|bd) D_cd of a symmetric
+// density, from the blocks of unique shell quartets in any order. A block
+// is the (ab|cd) of four function ranges, func[x] ~ func[x] + nfunc[x] - 1,
+// in the layout of EriClass::eriVal. The ranges of a pair are either the
+// same or the first lies after the second, as for the canonical quartets
+// of BasisSet, and no quartet of functions may come twice.
+//
+// Each unique (ij|kl), i >= j, k >= l, ij >= kl, is weighted by the number
+// of its permutations and added once to J'_ij, J'_kl and K'_ik, K'_jl,
+// K'_il, K'_jk. The other halves of the permutations are the transposes,
+// J = (J' + J'^T) / 4 and K = (K' + K'^T) / 8.
+class JKBuilder {
+public:
+    // D is used by reference and must outlive the builder
+    explicit JKBuilder(const nhfMath::Matrix &D);
+
+    void add(const std::size_t *func, const std::size_t *nfunc, const double *v);
+
+    // J += J of the blocks so far, likewise K
+    void add_to(nhfMath::Matrix &J, nhfMath::Matrix &K) const;
+
+private:
+    const nhfMath::Matrix *D;
+    std::size_t            n;
+    std::vector<double>    Jp, Kp;      // J', K'
+};
+
+// J and K of the densities of successive SCF iterations. J and K are
+// linear in D, so after the first build only the change of the density
+// is contracted, J(D_n) = J(D_n-1) + J(D_n - D_n-1) and likewise K. Near
+// convergence the change is small, and opt.densityThresh screens out
+// most quartets of the increment. The quartets dropped by each increment
+// add up, so every rebuildEvery-th update is a full build again.
+class IncrementalJK {
+public:
+    nhfMath::Matrix J, K;          // of the density of the last update
+    EriStat     stat;           // of the last update
+    bool        full;           // the last update was a full build
+    int         rebuildEvery;   // <= 0 never rebuilds after the first
+
+    IncrementalJK(const tho::BasisSet &bsSet,
+                  const EriOption &opt = EriOption(EriEngine::Hgp, 1e-12, 0.0, 1e-10),
+                  int rebuildEvery = 8);
+
+    // J and K of D
+    void update(const nhfMath::Matrix &D);
+
+    // the next update is a full build
+    void reset() { nIncrement = -1; }
+
+private:
+    const tho::BasisSet *bsSet;
+    EriOption            opt;
+    int                  nIncrement;    // increments since the last full build,
+                                        // -1 before the first one
+    nhfMath::Matrix      lastD;
+};
+
+}   // namespace (nhfInt)
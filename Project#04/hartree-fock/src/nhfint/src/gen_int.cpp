@@ -0,0 +1,126 @@
+#include "gen_int.hpp"
+#include "hgp_int.hpp"
+#include "tho_int.hpp"
+#include "boysfun.hpp"
+#ifdef NHFINT_GENERATED_ERI
+#include "eri_gen.hpp"
+#endif
+#include <algorithm>
+#include <vector>
+#include <cstddef>
+#include <cassert>
+
+namespace nhfInt {
+namespace gen {
+
+#ifdef NHFINT_GENERATED_ERI
+namespace {
+
+// nhfGen::BoysFun of an nhfBoys::BoysEvaluator
+void boys_batch(const void *ctx, int mmax, const double *T, std::size_t nT, double *fm) {
+    static_cast<const nhfBoys::BoysEvaluator*>(ctx)->all(mmax, T, nT, fm);
+}
+
+nhfGen::PairData pair_data(const Shell &a, const ShellPair &ab) {
+    nhfGen::PairData ret;
+    ret.nprim = ab.nprim();
+    ret.zeta = ab.zeta.data();
+    ret.Px = ab.Px.data();
+    ret.Py = ab.Py.data();
+    ret.Pz = ab.Pz.data();
+    ret.K = ab.K.data();
+    for (std::size_t i = 0; i < 3; ++i) {
+        ret.A[i] = a.centre[i];
+        ret.AB[i] = ab.AB[i];
+    }
+    return ret;
+}
+
+}   // namespace (anonymous)
+#endif
+
+
+bool has_kernel(int La, int Lb, int Lc, int Ld) {
+#ifdef NHFINT_GENERATED_ERI
+    return nhfGen::kernel(La, Lb, Lc, Ld) != nullptr;
+#else
+    (void)La; (void)Lb; (void)Lc; (void)Ld;
+    return false;
+#endif
+}
+
+void int_repulsion(EriClass &eri,
+                   const Shell &a, const Shell &b,
+                   const Shell &c, const Shell &d,
+                   const ShellPair &ab, const ShellPair &cd,
+                   const nhfBoys::BoysEvaluator &boys) {
+#ifdef NHFINT_GENERATED_ERI
+    nhfGen::Kernel kernel = nhfGen::kernel(a.L, b.L, c.L, d.L);
+    if (kernel != nullptr) {
+        eri.reset(a.L, b.L, c.L, d.L);
+        kernel(pair_data(a, ab), pair_data(c, cd), &boys_batch, &boys, eri.eriVal.data());
+
+        for (std::size_t ia = 0; ia < a.size(); ++ia) {
+        for (std::size_t ib = 0; ib < b.size(); ++ib) {
+        for (std::size_t ic = 0; ic < c.size(); ++ic) {
+        for (std::size_t id = 0; id < d.size(); ++id) {
+            eri(ia, ib, ic, id) *= a.scale[ia] * b.scale[ib]
+                                 * c.scale[ic] * d.scale[id];
+        }}}}
+        return;
+    }
+#endif
+    hgp::int_repulsion(eri, a, b, c, d, ab, cd, boys);
+}
+
+void int_repulsion_batch(const std::vector<Shell> &shList,
+                         const tho::ShellPairList &spList,
+                         const ShellQuartet *quartet, std::size_t n,
+                         double *out, const nhfBoys::BoysEvaluator &boys) {
+    if (n == 0) return;
+
+    const ShellQuartet &q0 = quartet[0];
+    const Shell &a0 = shList[q0.a], &b0 = shList[q0.b];
+    const Shell &c0 = shList[q0.c], &d0 = shList[q0.d];
+    std::size_t nCart = a0.size() * b0.size() * c0.size() * d0.size();
+
+#ifdef NHFINT_GENERATED_ERI
+    nhfGen::Kernel kernel = nhfGen::kernel(a0.L, b0.L, c0.L, d0.L);
+    if (kernel != nullptr) {
+        // the scales depend only on the Cartesian components
+        std::vector<double> scale(nCart);
+        std::size_t k = 0;
+        for (std::size_t ia = 0; ia < a0.size(); ++ia) {
+        for (std::size_t ib = 0; ib < b0.size(); ++ib) {
+        for (std::size_t ic = 0; ic < c0.size(); ++ic) {
+        for (std::size_t id = 0; id < d0.size(); ++id) {
+            scale[k++] = a0.scale[ia] * b0.scale[ib]
+                       * c0.scale[ic] * d0.scale[id];
+        }}}}
+
+        for (std::size_t i = 0; i < n; ++i) {
+            const ShellQuartet &q = quartet[i];
+            assert(shList[q.a].L == a0.L && shList[q.b].L == b0.L &&
+                   shList[q.c].L == c0.L && shList[q.d].L == d0.L);
+            double *o = out + i * nCart;
+            kernel(pair_data(shList[q.a], spList(q.a, q.b)),
+                   pair_data(shList[q.c], spList(q.c, q.d)), &boys_batch, &boys, o);
+            for (std::size_t j = 0; j < nCart; ++j) {
+                o[j] *= scale[j];
+            }
+        }
+        return;
+    }
+#endif
+
+    EriClass eri;
+    for (std::size_t i = 0; i < n; ++i) {
+        const ShellQuartet &q = quartet[i];
+        hgp::int_repulsion(eri, shList[q.a], shList[q.b], shList[q.c], shList[q.d],
+                           spList(q.a, q.b), spList(q.c, q.d), boys);
+        std::copy(eri.eriVal.begin(), eri.eriVal.end(), out + i * nCart);
+    }
+}
+
+}   // namespace (gen)
+}   // namespace (nhfInt)
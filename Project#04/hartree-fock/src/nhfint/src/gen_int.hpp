@@ -0,0 +1,35 @@
+#pragma once
+
+#include "tho_basis.hpp"
+#include "eri_class.hpp"
+#include <vector>
+#include <cstddef>
+
+namespace nhfInt {
+namespace gen {
+
+using tho::Shell;
+using tho::ShellPair;
+
+// true when nhfint was built with the generated kernels
+// (NHFINT_GENERATED_ERI) and (La Lb|Lc Ld) is one of them
+bool has_kernel(int La, int Lb, int Lc, int Ld);
+
+// (ab|cd) with the kernel written by nhfint_gen, the classes that were
+// not generated go to hgp::int_repulsion
+void int_repulsion(EriClass &eri,
+                   const Shell &a, const Shell &b,
+                   const Shell &c, const Shell &d,
+                   const ShellPair &ab, const ShellPair &cd,
+                   const nhfBoys::BoysEvaluator &boys = nhfBoys::boys_taylor());
+
+// (ab|cd) of n quartets of one class, see nhfInt::int_repulsion_batch.
+// The kernel and the component scales are looked up once for the batch.
+void int_repulsion_batch(const std::vector<Shell> &shList,
+                         const tho::ShellPairList &spList,
+                         const ShellQuartet *quartet, std::size_t n,
+                         double *out,
+                         const nhfBoys::BoysEvaluator &boys = nhfBoys::boys_taylor());
+
+}   // namespace (gen)
+}   // namespace (nhfInt)
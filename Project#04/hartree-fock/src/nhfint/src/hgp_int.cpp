@@ -0,0 +1,669 @@
+#include "hgp_int.hpp"
+#include "cartesian.hpp"
+#include "tho_int.hpp"
+#include "boysfun.hpp"
+#include "constant.hpp"
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+#include <cmath>
+#include <cassert>
+#include <cstddef>
+
+namespace nhfInt {
+namespace hgp {
+
+using nhfMath::Vec3d;
+
+namespace {
+
+constexpr std::size_t ncart(int n)
+{ return std::size_t((n + 1) * (n + 2) / 2); }
+
+// sum of ncart(n), n = lo ~ hi
+constexpr std::size_t ncart_sum(int lo, int hi)
+{ return lo > hi ? 0 : ncart(lo) + ncart_sum(lo + 1, hi); }
+
+// size of the VRR blocks (e,f), f = 0 ~ Lcd, of one e
+constexpr std::size_t vrr_row(int e, int Lcd, int Lsum)
+{ return Lcd < 0 ? 0 : vrr_row(e, Lcd - 1, Lsum) + ncart(e) * ncart(Lcd) * (Lsum - e - Lcd + 1); }
+
+// size of the VRR blocks (e,f), e = 0 ~ Lab, f = 0 ~ Lcd
+constexpr std::size_t vrr_size(int Lab, int Lcd, int Lsum)
+{ return Lab < 0 ? 0 : vrr_size(Lab - 1, Lcd, Lsum) + vrr_row(Lab, Lcd, Lsum); }
+
+// number of (x,y) components of the HRR blocks y = 0 ~ ly, x = Lx ~ Lx+Ly-y
+constexpr std::size_t hrr_size(int Lx, int Ly, int ly)
+{ return ly < 0 ? 0 : hrr_size(Lx, Ly, ly - 1) + ncart(ly) * ncart_sum(Lx, Lx + Ly - ly); }
+
+// offset of the VRR block (e,f), k = e * (Lcd+1) + f, as vrr_offsets
+constexpr std::size_t vrr_offset(int Lab, int Lcd, std::size_t k)
+{ return vrr_size(int(k) / (Lcd + 1) - 1, Lcd, Lab + Lcd)
+       + vrr_row(int(k) / (Lcd + 1), int(k) % (Lcd + 1) - 1, Lab + Lcd); }
+
+// offset of the HRR block (x,y), k = y * (Ly+1) + x - Lx, as hrr_offsets
+constexpr std::size_t hrr_offset(int Lx, int Ly, std::size_t width, std::size_t k)
+{ return (hrr_size(Lx, Ly, int(k) / (Ly + 1) - 1)
+        + ncart(int(k) / (Ly + 1)) * ncart_sum(Lx, Lx + int(k) % (Ly + 1) - 1)) * width; }
+
+
+// 0, 1, ..., N-1 as a type, to fill constexpr tables element by element
+template <std::size_t... I>
+struct IndexSeq {};
+
+template <std::size_t N, std::size_t... I>
+struct MakeIndexSeq : MakeIndexSeq<N - 1, N - 1, I...> {};
+
+template <std::size_t... I>
+struct MakeIndexSeq<0, I...> { typedef IndexSeq<I...> type; };
+
+
+// ==================== Cartesian index tables =====================
+// The recurrences step from a component m of shell n to m - 1_d, m - 2_d
+// and m + 1_d. CartTable holds these steps for every component of the
+// shells 0 ~ MAX_TABLE_L, computed by the compiler, so the kernels read
+// them from a constant table instead of walking cart_list and calling
+// reduce_dir and index_minus on every component.
+const int MAX_TABLE_L = 12;     // Lab of (ii|ii)
+
+struct CartInfo {
+    int         comp[3];    // i, j, k
+    int         dir;        // reduce_dir(m)
+    std::size_t minus[3];   // index of m - 1_d in shell n-1, 0 if comp[d] == 0
+    std::size_t minus2;     // index of m - 2_dir in shell n-2, 0 if comp[dir] < 2
+    std::size_t plus[3];    // index of m + 1_d in shell n+1
+};
+
+// first element of shell n in CartTable
+constexpr std::size_t cart_start(int n)
+{ return std::size_t(n) * (n + 1) * (n + 2) / 6; }
+
+// index_of_ijk, first component of i in shell n
+constexpr std::size_t ijk_start(int n, int i)
+{ return std::size_t((2 * n - i + 3) * i / 2); }
+
+constexpr std::size_t ijk_index(int i, int j, int k)
+{ return ijk_start(i + j + k, i) + j; }
+
+// shell of element t of CartTable, and i of component c of shell n
+constexpr int cart_shell(std::size_t t, int n = 0)
+{ return t < cart_start(n + 1) ? n : cart_shell(t, n + 1); }
+
+constexpr int cart_i(int n, std::size_t c, int i = 0)
+{ return c < ijk_start(n, i + 1) ? i : cart_i(n, c, i + 1); }
+
+constexpr CartInfo make_cart_info(int i, int j, int k) {
+    return CartInfo{{i, j, k}, i > 0 ? 0 : (j > 0 ? 1 : 2),
+        {i > 0 ? ijk_index(i - 1, j, k) : 0,
+         j > 0 ? ijk_index(i, j - 1, k) : 0,
+         k > 0 ? ijk_index(i, j, k - 1) : 0},
+        i > 0 ? (i > 1 ? ijk_index(i - 2, j, k) : 0)
+              : j > 0 ? (j > 1 ? ijk_index(i, j - 2, k) : 0)
+                      : (k > 1 ? ijk_index(i, j, k - 2) : 0),
+        {ijk_index(i + 1, j, k), ijk_index(i, j + 1, k), ijk_index(i, j, k + 1)}};
+}
+
+constexpr CartInfo make_cart_info(int n, std::size_t c, int i)
+{ return make_cart_info(i, int(c - ijk_start(n, i)), n - i - int(c - ijk_start(n, i))); }
+
+constexpr CartInfo make_cart_info(std::size_t t)
+{ return make_cart_info(cart_shell(t), t - cart_start(cart_shell(t)),
+                        cart_i(cart_shell(t), t - cart_start(cart_shell(t)))); }
+
+template <class Seq>
+struct CartTable;
+
+template <std::size_t... I>
+struct CartTable<IndexSeq<I...>> {
+    static constexpr CartInfo info[sizeof...(I)] = {make_cart_info(I)...};
+};
+
+template <std::size_t... I>
+constexpr CartInfo CartTable<IndexSeq<I...>>::info[sizeof...(I)];
+
+typedef CartTable<MakeIndexSeq<cart_start(MAX_TABLE_L + 1)>::type> CartInfoTable;
+
+// the steps of component c of shell n
+inline const CartInfo& cart_info(int n, std::size_t c) {
+    assert(n <= MAX_TABLE_L);
+    return CartInfoTable::info[cart_start(n) + c];
+}
+
+
+// block offsets of a VRR buffer, off[e * (Lcd+1) + f], returns the size
+std::size_t vrr_offsets(int Lab, int Lcd, std::size_t *off) {
+    std::size_t size = 0;
+    for (int e = 0; e <= Lab; ++e) {
+    for (int f = 0; f <= Lcd; ++f) {
+        off[e * (Lcd + 1) + f] = size;
+        size += ncart(e) * ncart(f) * (Lab + Lcd - e - f + 1);
+    }}
+    return size;
+}
+
+// block offsets of a HRR buffer, off[y * (Ly+1) + x - Lx], returns the size
+std::size_t hrr_offsets(int Lx, int Ly, std::size_t width, std::size_t *off) {
+    std::size_t size = 0;
+    for (int y = 0; y <= Ly; ++y) {
+    for (int x = Lx; x <= Lx + Ly - y; ++x) {
+        off[y * (Ly + 1) + x - Lx] = size;
+        size += ncart(x) * ncart(y) * width;
+    }}
+    return size;
+}
+
+
+// [e0|f0]^(m) of one primitive quartet, e = 0 ~ Lab, f = 0 ~ Lcd and
+// m = 0 ~ Lab+Lcd-e-f. One (e,f) block is stored as [ce][cf][m].
+class VrrBuffer {
+public:
+    int Lab, Lcd;
+    std::vector<std::size_t> off;
+    std::vector<double> val;
+
+    VrrBuffer(int Lab, int Lcd)
+    : Lab(Lab), Lcd(Lcd), off((Lab + 1) * (Lcd + 1)) {
+        val.resize(vrr_offsets(Lab, Lcd, off.data()));
+    }
+
+    std::size_t nm(int e, int f) const { return std::size_t(Lab + Lcd - e - f + 1); }
+
+    double* operator()(int e, int f) { return &val[off[e * (Lcd + 1) + f]]; }
+};
+
+// the same with the sizes and the offsets known at compile time, kept
+// on the stack
+template <int Lab_, int Lcd_,
+          class Seq = typename MakeIndexSeq<(Lab_ + 1) * (Lcd_ + 1)>::type>
+class FixedVrrBuffer;
+
+template <int Lab_, int Lcd_, std::size_t... I>
+class FixedVrrBuffer<Lab_, Lcd_, IndexSeq<I...>> {
+public:
+    static const int Lab = Lab_, Lcd = Lcd_;
+    static constexpr std::size_t off[sizeof...(I)] = {vrr_offset(Lab_, Lcd_, I)...};
+    double val[vrr_size(Lab, Lcd, Lab + Lcd)];
+
+    std::size_t nm(int e, int f) const { return std::size_t(Lab + Lcd - e - f + 1); }
+
+    double* operator()(int e, int f) { return &val[off[e * (Lcd + 1) + f]]; }
+};
+
+template <int Lab_, int Lcd_, std::size_t... I>
+constexpr std::size_t FixedVrrBuffer<Lab_, Lcd_, IndexSeq<I...>>::off[sizeof...(I)];
+
+
+// HRR blocks (x,y), y = 0 ~ Ly and x = Lx ~ Lx+Ly-y, each holding
+// ncart(x) * ncart(y) * width values
+class HrrBuffer {
+public:
+    int Lx, Ly;
+    std::vector<std::size_t> off;
+    std::vector<double> val;
+
+    HrrBuffer(int Lx, int Ly, std::size_t width)
+    : Lx(Lx), Ly(Ly), off((Ly + 1) * (Ly + 1)) {
+        val.resize(hrr_offsets(Lx, Ly, width, off.data()));
+    }
+
+    double* operator()(int x, int y) { return &val[off[y * (Ly + 1) + x - Lx]]; }
+};
+
+template <int Lx_, int Ly_, std::size_t width,
+          class Seq = typename MakeIndexSeq<(Ly_ + 1) * (Ly_ + 1)>::type>
+class FixedHrrBuffer;
+
+template <int Lx_, int Ly_, std::size_t width, std::size_t... I>
+class FixedHrrBuffer<Lx_, Ly_, width, IndexSeq<I...>> {
+public:
+    static const int Lx = Lx_, Ly = Ly_;
+    static constexpr std::size_t off[sizeof...(I)] = {hrr_offset(Lx_, Ly_, width, I)...};
+    double val[hrr_size(Lx, Ly, Ly) * width];
+
+    double* operator()(int x, int y) { return &val[off[y * (Ly + 1) + x - Lx]]; }
+};
+
+template <int Lx_, int Ly_, std::size_t width, std::size_t... I>
+constexpr std::size_t FixedHrrBuffer<Lx_, Ly_, width, IndexSeq<I...>>::off[sizeof...(I)];
+
+
+// scratch of one (ab|cd) class. The contracted (e0|f0) are accumulated
+// in bra(e,0), e = La ~ Lab, stored as [ce][kf] where kf runs over the
+// components of f = Lc ~ Lcd in turn.
+class Buffers {
+public:
+    int La, Lb, Lc, Ld;
+    std::size_t nket, nbra;
+    VrrBuffer vrr;
+    HrrBuffer bra, ket;
+    std::vector<double> fm;
+
+    Buffers(int La, int Lb, int Lc, int Ld)
+    : La(La), Lb(Lb), Lc(Lc), Ld(Ld),
+      nket(ncart_sum(Lc, Lc + Ld)), nbra(ncart(La) * ncart(Lb)),
+      vrr(La + Lb, Lc + Ld), bra(La, Lb, nket), ket(Lc, Ld, nbra),
+      fm(La + Lb + Lc + Ld + 1, 0.0) {}
+};
+
+template <int La_, int Lb_, int Lc_, int Ld_>
+class FixedBuffers {
+public:
+    static const int La = La_, Lb = Lb_, Lc = Lc_, Ld = Ld_;
+    static const std::size_t nket = ncart_sum(Lc, Lc + Ld);
+    static const std::size_t nbra = ncart(La) * ncart(Lb);
+    FixedVrrBuffer<La + Lb, Lc + Ld> vrr;
+    FixedHrrBuffer<La, Lb, nket> bra;
+    FixedHrrBuffer<Lc, Ld, nbra> ket;
+    double fm[La + Lb + Lc + Ld + 1];
+};
+
+
+// I = Lo ~ Hi as std::integral_constant, to run the steps below for
+// every block of a fixed class: F is a functor with step(I)
+template <int Lo, int Hi, bool = (Lo > Hi)>
+struct StaticFor {
+    template <class F>
+    static void run(F &f) {
+        f.step(std::integral_constant<int, Lo>());
+        StaticFor<Lo + 1, Hi>::run(f);
+    }
+};
+
+template <int Lo, int Hi>
+struct StaticFor<Lo, Hi, true> {
+    template <class F>
+    static void run(F &) {}
+};
+
+
+// coefficients of the VRR of one primitive quartet
+struct VrrCoef {
+    double PA[3], WP[3], QC[3], WQ[3];
+    double oo2z, roz, oo2e, roe, oo2ze;
+};
+
+// The steps of the VRR take the shells e and f as int for a VrrBuffer,
+// or as std::integral_constant for a FixedVrrBuffer. Then each step is
+// compiled for its own e and f, and its trip counts, block offsets and
+// CartTable lookups are constants.
+
+// [a+1i,0|00]^(m) = PA_i [a0|00]^(m) + WP_i [a0|00]^(m+1)
+//                 + a_i/2z ([a-1i,0|00]^(m) - rho/z [a-1i,0|00]^(m+1))
+// for the block (e,0), e >= 1
+template <class Vrr, class E>
+void vrr_bra(Vrr &v, const VrrCoef &k, E e) {
+    const std::size_t nm = v.nm(e, 0);
+    for (std::size_t ce = 0; ce < ncart(e); ++ce) {
+        const CartInfo &t = cart_info(e, ce);
+        int dir = t.dir;
+        int na = t.comp[dir] - 1;
+
+        double *out = v(e, 0) + ce * nm;
+        const double *p1 = v(e-1, 0) + t.minus[dir] * (nm + 1);
+        for (std::size_t m = 0; m < nm; ++m) {
+            out[m] = k.PA[dir] * p1[m] + k.WP[dir] * p1[m+1];
+        }
+
+        if (e > 1 && na > 0) {
+            const double *p2 = v(e-2, 0) + t.minus2 * (nm + 2);
+            for (std::size_t m = 0; m < nm; ++m) {
+                out[m] += na * k.oo2z * (p2[m] - k.roz * p2[m+1]);
+            }
+        }
+    }
+}
+
+// [a0|c+1i,0]^(m) = QC_i [a0|c0]^(m) + WQ_i [a0|c0]^(m+1)
+//                 + c_i/2e ([a0|c-1i,0]^(m) - rho/e [a0|c-1i,0]^(m+1))
+//                 + a_i/2(z+e) [a-1i,0|c0]^(m+1)
+// for the block (e,f), f >= 1
+template <class Vrr, class E, class F>
+void vrr_ket(Vrr &v, const VrrCoef &k, E e, F f) {
+    const std::size_t ncf = ncart(f), ncf1 = ncart(f-1);
+    const std::size_t ncf2 = f > 1 ? ncart(f-2) : 0;
+    const std::size_t nm = v.nm(e, f);
+
+    for (std::size_t ce = 0; ce < ncart(e); ++ce) {
+    for (std::size_t cf = 0; cf < ncf; ++cf) {
+        const CartInfo &t = cart_info(f, cf), &s = cart_info(e, ce);
+        int dir = t.dir;
+        int nc = t.comp[dir] - 1;
+        int na = s.comp[dir];
+        std::size_t c1 = t.minus[dir];
+
+        double *out = v(e, f) + (ce * ncf + cf) * nm;
+        const double *p1 = v(e, f-1) + (ce * ncf1 + c1) * (nm + 1);
+        for (std::size_t m = 0; m < nm; ++m) {
+            out[m] = k.QC[dir] * p1[m] + k.WQ[dir] * p1[m+1];
+        }
+
+        if (f > 1 && nc > 0) {
+            const double *p2 = v(e, f-2) + (ce * ncf2 + t.minus2) * (nm + 2);
+            for (std::size_t m = 0; m < nm; ++m) {
+                out[m] += nc * k.oo2e * (p2[m] - k.roe * p2[m+1]);
+            }
+        }
+
+        if (e > 0 && na > 0) {
+            const double *p3 = v(e-1, f-1) + (s.minus[dir] * ncf1 + c1) * (nm + 2);
+            for (std::size_t m = 0; m < nm; ++m) {
+                out[m] += na * k.oo2ze * p3[m+1];
+            }
+        }
+    }}
+}
+
+// adds [e0|f0]^(0) to the contracted bra(e,0) of buf, where the
+// components of f start at ketOff
+template <class Buf, class E, class F>
+void vrr_contract(Buf &buf, E e, F f, std::size_t ketOff) {
+    const std::size_t ncf = ncart(f), nm = buf.vrr.nm(e, f);
+    const double *src = buf.vrr(e, f);
+    for (std::size_t ce = 0; ce < ncart(e); ++ce) {
+        double *dst = buf.bra(e, 0) + ce * buf.nket + ketOff;
+        for (std::size_t cf = 0; cf < ncf; ++cf) {
+            dst[cf] += src[(ce * ncf + cf) * nm];
+        }
+    }
+}
+
+template <class Vrr>
+void vrr_init(Vrr &v, const double *fm) {
+    // [00|00]^(m)
+    double *s = v(0, 0);
+    for (std::size_t m = 0; m < v.nm(0, 0); ++m) {
+        s[m] = fm[m];
+    }
+}
+
+// Obara-Saika VRR of all blocks and their contraction into buf.bra,
+// one step after the other
+void vrr(Buffers &buf, const double *fm, const VrrCoef &k, const std::size_t *ketOff) {
+    VrrBuffer &v = buf.vrr;
+    vrr_init(v, fm);
+    for (int e = 1; e <= v.Lab; ++e) {
+        vrr_bra(v, k, e);
+    }
+    for (int f = 1; f <= v.Lcd; ++f) {
+    for (int e = 0; e <= v.Lab; ++e) {
+        vrr_ket(v, k, e, f);
+    }}
+
+    for (int e = buf.La; e <= v.Lab; ++e) {
+    for (int f = buf.Lc; f <= v.Lcd; ++f) {
+        vrr_contract(buf, e, f, ketOff[f - buf.Lc]);
+    }}
+}
+
+// functors of StaticFor for the steps of a FixedBuffers
+template <class Buf>
+struct VrrBraSteps {
+    Buf &buf;
+    const VrrCoef &k;
+    template <class E> void step(E e) { vrr_bra(buf.vrr, k, e); }
+};
+
+template <class Buf, int F>
+struct VrrKetRow {
+    Buf &buf;
+    const VrrCoef &k;
+    template <class E> void step(E e) { vrr_ket(buf.vrr, k, e, std::integral_constant<int, F>()); }
+};
+
+template <class Buf>
+struct VrrKetSteps {
+    Buf &buf;
+    const VrrCoef &k;
+    template <class F> void step(F) {
+        VrrKetRow<Buf, F::value> row = {buf, k};
+        StaticFor<0, Buf::La + Buf::Lb>::run(row);
+    }
+};
+
+template <class Buf, int E>
+struct VrrContractRow {
+    Buf &buf;
+    const std::size_t *ketOff;
+    template <class F> void step(F f)
+    { vrr_contract(buf, std::integral_constant<int, E>(), f, ketOff[f - Buf::Lc]); }
+};
+
+template <class Buf>
+struct VrrContractSteps {
+    Buf &buf;
+    const std::size_t *ketOff;
+    template <class E> void step(E) {
+        VrrContractRow<Buf, E::value> row = {buf, ketOff};
+        StaticFor<Buf::Lc, Buf::Lc + Buf::Ld>::run(row);
+    }
+};
+
+// the same for FixedBuffers, with the steps unrolled at compile time
+template <int La, int Lb, int Lc, int Ld>
+void vrr(FixedBuffers<La, Lb, Lc, Ld> &buf, const double *fm, const VrrCoef &k,
+         const std::size_t *ketOff) {
+    typedef FixedBuffers<La, Lb, Lc, Ld> Buf;
+    vrr_init(buf.vrr, fm);
+    VrrBraSteps<Buf> bra = {buf, k};
+    StaticFor<1, La + Lb>::run(bra);
+    VrrKetSteps<Buf> ket = {buf, k};
+    StaticFor<1, Lc + Ld>::run(ket);
+    VrrContractSteps<Buf> contract = {buf, ketOff};
+    StaticFor<La, La + Lb>::run(contract);
+}
+
+
+// Head-Gordon-Pople (ab|cd) with the scratch buf, which is either
+// Buffers or FixedBuffers. With FixedBuffers every loop bound below is
+// a compile-time constant, and the VRR, which runs once per primitive
+// quartet, is unrolled block by block.
+template <class Buf>
+void hgp_kernel(Buf &buf, EriClass &eri,
+                const Shell &a, const Shell &b,
+                const Shell &c, const Shell &d,
+                const ShellPair &ab, const ShellPair &cd,
+                const nhfBoys::BoysEvaluator &boys) {
+    const int La = buf.La, Lb = buf.Lb, Lc = buf.Lc, Ld = buf.Ld;
+    const int Lab = La + Lb, Lcd = Lc + Ld;
+    const std::size_t nket = buf.nket, nbra = buf.nbra;
+    eri.reset(La, Lb, Lc, Ld);
+
+    const Vec3d &A = a.centre, &C = c.centre;
+
+    std::size_t ketOff[MAX_CART_ANG + 1];
+    for (int f = Lc; f <= Lcd; ++f) {
+        ketOff[f - Lc] = ncart_sum(Lc, f - 1);
+    }
+    for (int e = La; e <= Lab; ++e) {
+        std::fill(buf.bra(e, 0), buf.bra(e, 0) + ncart(e) * nket, 0.0);
+    }
+
+    // ==================== VRR with early contraction =====================
+    for (std::size_t kab = 0; kab < ab.nprim(); ++kab) {
+        double zeta = ab.zeta[kab];
+        Vec3d P = ab.P(kab);
+        double Kab = ab.K[kab];
+        VrrCoef k;
+        k.PA[0] = P.x - A.x;
+        k.PA[1] = P.y - A.y;
+        k.PA[2] = P.z - A.z;
+        k.oo2z = 0.5 / zeta;
+
+        for (std::size_t kcd = 0; kcd < cd.nprim(); ++kcd) {
+            double eta = cd.zeta[kcd];
+            Vec3d Q = cd.P(kcd);
+            double Kcd = cd.K[kcd];
+
+            double rho = zeta * eta / (zeta + eta);
+            Vec3d W = (zeta * P + eta * Q) / (zeta + eta);
+            k.QC[0] = Q.x - C.x;  k.WP[0] = W.x - P.x;  k.WQ[0] = W.x - Q.x;
+            k.QC[1] = Q.y - C.y;  k.WP[1] = W.y - P.y;  k.WQ[1] = W.y - Q.y;
+            k.QC[2] = Q.z - C.z;  k.WP[2] = W.z - P.z;  k.WQ[2] = W.z - Q.z;
+            k.roz = rho / zeta;
+            k.oo2e = 0.5 / eta;
+            k.roe = rho / eta;
+            k.oo2ze = 0.5 / (zeta + eta);
+
+            double pre = 2.0 * std::pow(nhfMath::PI, 2.5)
+                       / (zeta * eta * std::sqrt(zeta + eta)) * Kab * Kcd;
+            double T = rho * (P - Q).len2();
+            boys.all(Lab + Lcd, T, &buf.fm[0]);
+            for (int m = 0; m <= Lab + Lcd; ++m) {
+                buf.fm[m] *= pre;
+            }
+
+            vrr(buf, &buf.fm[0], k, ketOff);
+        }
+    }
+
+    // ==================== bra HRR =====================
+    // (e,b+1i| = (e+1i,b| + AB_i (e,b|, for every ket component kf,
+    // bra(e,b) is stored as [ce][cb][kf]
+    double AB[3] = {ab.AB.x, ab.AB.y, ab.AB.z};
+    for (int lb = 1; lb <= Lb; ++lb) {
+        std::size_t ncb = ncart(lb), ncb1 = ncart(lb-1);
+        for (int e = La; e <= Lab - lb; ++e) {
+            const double *in1 = buf.bra(e + 1, lb - 1);
+            const double *in0 = buf.bra(e, lb - 1);
+            double *out = buf.bra(e, lb);
+
+            for (std::size_t ce = 0; ce < ncart(e); ++ce) {
+            for (std::size_t cb = 0; cb < ncb; ++cb) {
+                const CartInfo &tb = cart_info(lb, cb);
+                int dir = tb.dir;
+                std::size_t b1 = tb.minus[dir];
+                std::size_t e1 = cart_info(e, ce).plus[dir];
+                double *o = out + (ce * ncb + cb) * nket;
+                const double *i1 = in1 + (e1 * ncb1 + b1) * nket;
+                const double *i0 = in0 + (ce * ncb1 + b1) * nket;
+                for (std::size_t k = 0; k < nket; ++k) {
+                    o[k] = i1[k] + AB[dir] * i0[k];
+                }
+            }}
+        }
+    }
+
+    // ==================== ket HRR =====================
+    // |f,d+1i) = |f+1i,d) + CD_i |f,d), for every bra component (ab|,
+    // ket(f,d) is stored as [ab][cf][cd]
+    double CD[3] = {cd.AB.x, cd.AB.y, cd.AB.z};
+    const double *braVal = buf.bra(La, Lb);
+    for (int f = Lc; f <= Lcd; ++f) {
+        std::size_t ncf = ncart(f);
+        double *out = buf.ket(f, 0);
+        for (std::size_t r = 0; r < nbra; ++r) {
+        for (std::size_t cf = 0; cf < ncf; ++cf) {
+            out[r * ncf + cf] = braVal[r * nket + ketOff[f - Lc] + cf];
+        }}
+    }
+
+    for (int ld = 1; ld <= Ld; ++ld) {
+        std::size_t ncd = ncart(ld), ncd1 = ncart(ld-1);
+        for (int f = Lc; f <= Lcd - ld; ++f) {
+            std::size_t ncf = ncart(f), ncf1 = ncart(f+1);
+            const double *in1 = buf.ket(f + 1, ld - 1);
+            const double *in0 = buf.ket(f, ld - 1);
+            double *out = buf.ket(f, ld);
+
+            for (std::size_t cf = 0; cf < ncf; ++cf) {
+            for (std::size_t cd = 0; cd < ncd; ++cd) {
+                const CartInfo &td = cart_info(ld, cd);
+                int dir = td.dir;
+                std::size_t d1 = td.minus[dir];
+                std::size_t f1 = cart_info(f, cf).plus[dir];
+                for (std::size_t r = 0; r < nbra; ++r) {
+                    out[(r * ncf + cf) * ncd + cd] =
+                          in1[(r * ncf1 + f1) * ncd1 + d1]
+                        + CD[dir] * in0[(r * ncf + cf) * ncd1 + d1];
+                }
+            }}
+        }
+    }
+
+    const double *ketVal = buf.ket(Lc, Ld);
+    std::size_t nket2 = c.size() * d.size();
+    for (std::size_t ia = 0; ia < a.size(); ++ia) {
+    for (std::size_t ib = 0; ib < b.size(); ++ib) {
+    for (std::size_t ic = 0; ic < c.size(); ++ic) {
+    for (std::size_t id = 0; id < d.size(); ++id) {
+        eri(ia, ib, ic, id) = ketVal[(ia * b.size() + ib) * nket2 + ic * d.size() + id]
+                            * a.scale[ia] * b.scale[ib] * c.scale[ic] * d.scale[id];
+    }}}}
+}
+
+
+template <int La, int Lb, int Lc, int Ld>
+void int_repulsion_fixed(EriClass &eri,
+                         const Shell &a, const Shell &b,
+                         const Shell &c, const Shell &d,
+                         const ShellPair &ab, const ShellPair &cd,
+                         const nhfBoys::BoysEvaluator &boys) {
+    FixedBuffers<La, Lb, Lc, Ld> buf;
+    hgp_kernel(buf, eri, a, b, c, d, ab, cd, boys);
+}
+
+typedef void (*FixedKernel)(EriClass &eri,
+                            const Shell &a, const Shell &b,
+                            const Shell &c, const Shell &d,
+                            const ShellPair &ab, const ShellPair &cd,
+                            const nhfBoys::BoysEvaluator &boys);
+
+// fill table[0..N] with the kernel of every (La Lb|Lc Ld), the index
+// is ((La * n + Lb) * n + Lc) * n + Ld with n = FIXED_MAX_L + 1
+template <int N>
+struct FixedTable {
+    static const int n = FIXED_MAX_L + 1;
+    static void fill(FixedKernel *table) {
+        table[N] = &int_repulsion_fixed<N / (n*n*n), N / (n*n) % n, N / n % n, N % n>;
+        FixedTable<N - 1>::fill(table);
+    }
+};
+
+template <>
+struct FixedTable<-1> {
+    static void fill(FixedKernel *) {}
+};
+
+const int NUM_FIXED = (FIXED_MAX_L + 1) * (FIXED_MAX_L + 1)
+                    * (FIXED_MAX_L + 1) * (FIXED_MAX_L + 1);
+
+const FixedKernel* fixed_table() {
+    static FixedKernel table[NUM_FIXED];
+    static bool init = (FixedTable<NUM_FIXED - 1>::fill(table), true);
+    (void)init;
+    return table;
+}
+
+}   // namespace (anonymous)
+
+
+void int_repulsion(EriClass &eri,
+                   const Shell &a, const Shell &b,
+                   const Shell &c, const Shell &d,
+                   const ShellPair &ab, const ShellPair &cd,
+                   const nhfBoys::BoysEvaluator &boys) {
+    const int n = FIXED_MAX_L + 1;
+    if (a.L < n && b.L < n && c.L < n && d.L < n) {
+        fixed_table()[((a.L * n + b.L) * n + c.L) * n + d.L](eri, a, b, c, d, ab, cd, boys);
+        return;
+    }
+    int_repulsion_generic(eri, a, b, c, d, ab, cd, boys);
+}
+
+void int_repulsion_generic(EriClass &eri,
+                           const Shell &a, const Shell &b,
+                           const Shell &c, const Shell &d,
+                           const ShellPair &ab, const ShellPair &cd,
+                           const nhfBoys::BoysEvaluator &boys) {
+    Buffers buf(a.L, b.L, c.L, d.L);
+    hgp_kernel(buf, eri, a, b, c, d, ab, cd, boys);
+}
+
+void int_repulsion(EriClass &eri,
+                   const Shell &a, const Shell &b,
+                   const Shell &c, const Shell &d) {
+    hgp::int_repulsion(eri, a, b, c, d, ShellPair(a, b), ShellPair(c, d));
+}
+
+}   // namespace (hgp)
+}   // namespace (nhfInt)
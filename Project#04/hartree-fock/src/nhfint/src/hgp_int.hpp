@@ -0,0 +1,43 @@
+#pragma once
+
+#include "tho_basis.hpp"
+#include "eri_class.hpp"
+#include "boysfun.hpp"
+
+namespace nhfInt {
+namespace hgp {
+
+using tho::Shell;
+using tho::ShellPair;
+
+// largest shell angular momentum with compile-time specialized kernels,
+// every class up to (dd|dd) has its own instance with fixed-size buffers
+// and a VRR unrolled block by block
+const int FIXED_MAX_L = 2;
+
+// Head-Gordon-Pople two-electron integrals.
+// The Obara-Saika vertical recurrence (VRR) builds [e0|f0] for every
+// primitive quartet, the results are contracted right away and the
+// horizontal recurrence (HRR) moves angular momentum from e to b and
+// from f to d on contracted integrals only. boys gives F_0 ~ F_m of
+// every primitive quartet.
+void int_repulsion(EriClass &eri,
+                   const Shell &a, const Shell &b,
+                   const Shell &c, const Shell &d,
+                   const ShellPair &ab, const ShellPair &cd,
+                   const nhfBoys::BoysEvaluator &boys = nhfBoys::boys_taylor());
+
+// the same without the specialized kernels, used when any L > FIXED_MAX_L
+void int_repulsion_generic(EriClass &eri,
+                           const Shell &a, const Shell &b,
+                           const Shell &c, const Shell &d,
+                           const ShellPair &ab, const ShellPair &cd,
+                           const nhfBoys::BoysEvaluator &boys = nhfBoys::boys_taylor());
+
+// the same, the shell pairs are built for this quartet
+void int_repulsion(EriClass &eri,
+                   const Shell &a, const Shell &b,
+                   const Shell &c, const Shell &d);
+
+}   // namespace (hgp)
+}   // namespace (nhfInt)
@@ -0,0 +1,273 @@
+#include "md_int.hpp"
+#include "tho_int.hpp"
+#include "boysfun.hpp"
+#include <vector>
+#include <cmath>
+#include <cstddef>
+
+namespace nhfInt {
+namespace md {
+
+using tho::AngMom;
+
+namespace {
+
+const double PI25X2 = 34.986836655249725;     // 2 pi^(5/2)
+
+// Hermite index (t,u,v) with t+u+v <= N
+struct HermiteIdx {
+    int t, u, v;
+};
+
+std::vector<HermiteIdx> hermite_list(int N) {
+    std::vector<HermiteIdx> ret;
+    for (int t = 0; t <= N; ++t) {
+    for (int u = 0; u <= N - t; ++u) {
+    for (int v = 0; v <= N - t - u; ++v) {
+        ret.push_back({t, u, v});
+    }}}
+    return ret;
+}
+
+// scratch of int_repulsion, per thread and only growing, so a loop of
+// ERI calls allocates only until it has seen its largest class
+struct MdScratch {
+    std::vector<std::vector<HermiteIdx>> tuv;   // hermite_list(N) by N
+    std::vector<std::size_t> off;               // R_{t+t',u+u',v+v'} of (tuv, t'u'v')
+    std::vector<double> R, buf, W, fm;
+};
+
+MdScratch& thread_scratch() {
+    static thread_local MdScratch scratch;
+    return scratch;
+}
+
+const std::vector<HermiteIdx>& tuv_list(MdScratch &scratch, int N) {
+    while (int(scratch.tuv.size()) <= N) {
+        scratch.tuv.push_back(hermite_list(int(scratch.tuv.size())));
+    }
+    return scratch.tuv[N];
+}
+
+// Hermite Coulomb integrals R_{tuv} = R^0_{tuv}, t+u+v <= L, from
+//   R^n_{000}     = (-2 alpha)^n F_n(alpha |PQ|^2)
+//   R^n_{t+1,u,v} = t R^{n+1}_{t-1,u,v} + X_PQ R^{n+1}_{tuv}
+// and the same for u and v. R and buf are cubes of side L+1.
+void hermite_r(int L, double alpha, const double *PQ, const double *fm,
+               std::vector<double> &R, std::vector<double> &buf) {
+    std::size_t side = L + 1;
+    auto idx = [side](int t, int u, int v) -> std::size_t
+    { return (t * side + u) * side + v; };
+
+    double m2a = -2.0 * alpha;
+    double pw = std::pow(m2a, L);
+
+    std::vector<double> *cur = &R, *prev = &buf;
+    if (L % 2 == 1) std::swap(cur, prev);   // level 0 must end up in R
+    (*cur)[0] = pw * fm[L];
+
+    for (int n = L - 1; n >= 0; --n) {
+        std::swap(cur, prev);
+        pw /= m2a;
+        std::vector<double> &B = *cur;
+        const std::vector<double> &A = *prev;
+
+        B[0] = pw * fm[n];
+        for (int t = 0; t <= L - n; ++t) {
+        for (int u = 0; u <= L - n - t; ++u) {
+        for (int v = 0; v <= L - n - t - u; ++v) {
+            if (t > 0) {
+                B[idx(t,u,v)] = PQ[0] * A[idx(t-1,u,v)]
+                              + (t > 1 ? (t-1) * A[idx(t-2,u,v)] : 0.0);
+            } else if (u > 0) {
+                B[idx(0,u,v)] = PQ[1] * A[idx(0,u-1,v)]
+                              + (u > 1 ? (u-1) * A[idx(0,u-2,v)] : 0.0);
+            } else if (v > 0) {
+                B[idx(0,0,v)] = PQ[2] * A[idx(0,0,v-1)]
+                              + (v > 1 ? (v-1) * A[idx(0,0,v-2)] : 0.0);
+            }
+        }}}
+    }
+}
+
+// E^{ab}_{tuv} of every component pair of one primitive pair,
+// stored as [ia * nb + ib][tuv]
+void component_hermite(const HermitePair &hp, const Shell &a, const Shell &b,
+                       const std::vector<HermiteIdx> &tuvList, double *out) {
+    std::size_t nTuv = tuvList.size();
+    for (std::size_t ia = 0; ia < a.size(); ++ia) {
+    for (std::size_t ib = 0; ib < b.size(); ++ib) {
+        const AngMom &ma = a.ijk[ia], &mb = b.ijk[ib];
+        double *o = out + (ia * b.size() + ib) * nTuv;
+        for (std::size_t k = 0; k < nTuv; ++k) {
+            const HermiteIdx &h = tuvList[k];
+            if (h.t > ma.i + mb.i || h.u > ma.j + mb.j || h.v > ma.k + mb.k) {
+                o[k] = 0.0;
+                continue;
+            }
+            o[k] = hp(0, ma.i, mb.i, h.t)
+                 * hp(1, ma.j, mb.j, h.u)
+                 * hp(2, ma.k, mb.k, h.v);
+        }
+    }}
+}
+
+}   // namespace (anonymous)
+
+
+HermitePair::HermitePair(const Shell &a, const Shell &b,
+                         const ShellPair &ab, std::size_t k)
+: La(a.L), Lb(b.L), p(ab.zeta[k]), P(ab.P(k)), K(ab.K[k]) {
+    const Vec3d &A = a.centre, &B = b.centre;
+
+    // E^{i+1,j}_t = 1/2p E^{ij}_{t-1} + X_PA E^{ij}_t + (t+1) E^{ij}_{t+1}
+    // E^{i,j+1}_t = 1/2p E^{ij}_{t-1} + X_PB E^{ij}_t + (t+1) E^{ij}_{t+1}
+    int nt = La + Lb + 1;
+    double oo2p = 0.5 * ab.invZeta[k];
+    for (int dir = 0; dir < 3; ++dir) {
+        std::vector<double> &e = E[dir];
+        e.assign((La+1) * (Lb+1) * nt, 0.0);
+        auto at = [this, nt](int i, int j) -> std::size_t
+        { return (i * (Lb+1) + j) * nt; };
+
+        double XPA = P[dir] - A[dir];
+        double XPB = P[dir] - B[dir];
+        e[0] = 1.0;
+        for (int i = 0; i <= La; ++i) {
+        for (int j = 0; j <= Lb; ++j) {
+            if (i == 0 && j == 0) continue;
+
+            // grow j when possible, otherwise grow i from (i-1,0)
+            const double *src = j > 0 ? &e[at(i, j-1)] : &e[at(i-1, 0)];
+            double X = j > 0 ? XPB : XPA;
+            int nSrc = j > 0 ? i + j - 1 : i - 1;   // largest t of src
+            double *dst = &e[at(i, j)];
+            for (int t = 0; t <= i + j; ++t) {
+                double val = 0.0;
+                if (t > 0 && t - 1 <= nSrc) val += oo2p * src[t-1];
+                if (t <= nSrc)              val += X * src[t];
+                if (t + 1 <= nSrc)          val += (t+1) * src[t+1];
+                dst[t] = val;
+            }
+        }}
+    }
+
+    std::vector<HermiteIdx> tuvList = hermite_list(La + Lb);
+    Eabc.assign(a.size() * b.size() * tuvList.size(), 0.0);
+    component_hermite(*this, a, b, tuvList, Eabc.data());
+}
+
+
+std::vector<HermitePair> hermite_pairs(const Shell &a, const Shell &b,
+                                       const ShellPair &ab) {
+    std::vector<HermitePair> ret;
+    ret.reserve(ab.nprim());
+    for (std::size_t k = 0; k < ab.nprim(); ++k) {
+        ret.push_back(HermitePair(a, b, ab, k));
+    }
+    return ret;
+}
+
+
+void int_repulsion(EriClass &eri,
+                   const Shell &a, const Shell &b,
+                   const Shell &c, const Shell &d,
+                   const std::vector<HermitePair> &bra,
+                   const std::vector<HermitePair> &ket,
+                   const nhfBoys::BoysEvaluator &boys) {
+    eri.reset(a.L, b.L, c.L, d.L);
+
+    int Lab = a.L + b.L, Lcd = c.L + d.L, Lsum = Lab + Lcd;
+    MdScratch &scratch = thread_scratch();
+    const std::vector<HermiteIdx> &tuvAB = tuv_list(scratch, Lab);
+    const std::vector<HermiteIdx> &tuvCD = tuv_list(scratch, Lcd);
+    std::size_t nAB = a.size() * b.size(), nCD = c.size() * d.size();
+    std::size_t nTuvAB = tuvAB.size(), nTuvCD = tuvCD.size();
+
+    // where each term of W_{tuv} below reads R, the same for every primitive
+    std::size_t side = Lsum + 1;
+    scratch.off.resize(nTuvAB * nTuvCD);
+    std::size_t *off = scratch.off.data();
+    for (std::size_t i = 0; i < nTuvAB; ++i) {
+    for (std::size_t j = 0; j < nTuvCD; ++j) {
+        const HermiteIdx &h = tuvAB[i], &g = tuvCD[j];
+        off[i * nTuvCD + j] = ((h.t + g.t) * side + h.u + g.u) * side + h.v + g.v;
+    }}
+
+    scratch.R.resize(side * side * side);
+    scratch.buf.resize(side * side * side);
+    scratch.W.resize(nTuvAB);
+    scratch.fm.resize(Lsum + 1);
+    double *R = scratch.R.data(), *W = scratch.W.data(), *fm = scratch.fm.data();
+
+    for (const HermitePair &hb : bra) {
+        for (const HermitePair &hk : ket) {
+            double p = hb.p, q = hk.p;
+            double alpha = p * q / (p + q);
+            double PQ[3] = {hb.P.x - hk.P.x, hb.P.y - hk.P.y, hb.P.z - hk.P.z};
+            double T = alpha * (PQ[0]*PQ[0] + PQ[1]*PQ[1] + PQ[2]*PQ[2]);
+            boys.all(Lsum, T, fm);
+            hermite_r(Lsum, alpha, PQ, fm, scratch.R, scratch.buf);
+
+            // the ket sign (-1)^(t'+u'+v') is (-1)^(t+u+v) of R_{t+t',u+u',v+v'}
+            // times (-1)^(t+u+v) of the bra, so it goes on R and on W
+            for (int t = 0; t <= Lsum; ++t) {
+            for (int u = 0; u <= Lsum - t; ++u) {
+            for (int v = (t + u + 1) % 2; v <= Lsum - t - u; v += 2) {
+                R[(t * side + u) * side + v] = -R[(t * side + u) * side + v];
+            }}}
+
+            double pre = PI25X2 / (p * q * std::sqrt(p + q)) * hb.K * hk.K;
+
+            for (std::size_t kc = 0; kc < nCD; ++kc) {
+                // W_{tuv} = sum_{t'u'v'} (-1)^(t'+u'+v') E^{cd}_{t'u'v'} R_{t+t',u+u',v+v'}
+                const double *e = &hk.Eabc[kc * nTuvCD];
+                for (std::size_t i = 0; i < nTuvAB; ++i) {
+                    const std::size_t *o = off + i * nTuvCD;
+                    double sum = 0.0;
+                    for (std::size_t j = 0; j < nTuvCD; ++j) {
+                        sum += e[j] * R[o[j]];
+                    }
+                    const HermiteIdx &h = tuvAB[i];
+                    W[i] = (h.t + h.u + h.v) % 2 == 1 ? -sum : sum;
+                }
+
+                for (std::size_t kb = 0; kb < nAB; ++kb) {
+                    const double *f = &hb.Eabc[kb * nTuvAB];
+                    double sum = 0.0;
+                    for (std::size_t i = 0; i < nTuvAB; ++i) {
+                        sum += f[i] * W[i];
+                    }
+                    eri.eriVal[kb * nCD + kc] += pre * sum;
+                }
+            }
+        }
+    }
+
+    for (std::size_t ia = 0; ia < a.size(); ++ia) {
+    for (std::size_t ib = 0; ib < b.size(); ++ib) {
+    for (std::size_t ic = 0; ic < c.size(); ++ic) {
+    for (std::size_t id = 0; id < d.size(); ++id) {
+        eri(ia, ib, ic, id) *= a.scale[ia] * b.scale[ib]
+                             * c.scale[ic] * d.scale[id];
+    }}}}
+}
+
+
+void int_repulsion(EriClass &eri,
+                   const Shell &a, const Shell &b,
+                   const Shell &c, const Shell &d,
+                   const ShellPair &ab, const ShellPair &cd,
+                   const nhfBoys::BoysEvaluator &boys) {
+    md::int_repulsion(eri, a, b, c, d,
+                  hermite_pairs(a, b, ab), hermite_pairs(c, d, cd), boys);
+}
+
+void int_repulsion(EriClass &eri,
+                   const Shell &a, const Shell &b,
+                   const Shell &c, const Shell &d) {
+    md::int_repulsion(eri, a, b, c, d, ShellPair(a, b), ShellPair(c, d));
+}
+
+}   // namespace (md)
+}   // namespace (nhfInt)
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "tho_basis.hpp"
+#include "eri_class.hpp"
+#include "boysfun.hpp"
+#include <vector>
+#include <cstddef>
+
+namespace nhfInt {
+namespace md {
+
+using tho::Shell;
+using tho::ShellPair;
+using nhfMath::Vec3d;
+
+// Hermite expansion of one primitive pair of two shells,
+//   x_A^i x_B^j exp(...) = K * sum_t E^{ij}_t Lambda_t
+// the same for y and z. E is computed once per primitive pair and
+// reused by every ket, J-engine or derivative code that needs it.
+// Eabc holds the products E^{ab}_{tuv} = E^{ij}_t E^{kl}_u E^{mn}_v of
+// every component pair (a, b), [ia * nb + ib][tuv] with the (t,u,v),
+// t+u+v <= La+Lb, in lexical order, so that int_repulsion does not
+// rebuild them for every quartet the pair takes part in.
+class HermitePair {
+public:
+    int     La, Lb;
+    double  p;          // alpha_a + alpha_b
+    Vec3d   P;          // gaussian product centre
+    double  K;          // exp(-ab/p |AB|^2) * coeff_a * coeff_b
+    std::vector<double> E[3];
+    std::vector<double> Eabc;
+
+    HermitePair(): La(0), Lb(0), p(0.0), K(0.0) {}
+    HermitePair(const Shell &a, const Shell &b,
+                const ShellPair &ab, std::size_t k);
+
+    // E^{ij}_t in direction dir, i <= La, j <= Lb, t <= i+j
+    double  operator()(int dir, int i, int j, int t) const
+    { return E[dir][(i * (Lb+1) + j) * (La+Lb+1) + t]; }
+};
+
+// all primitive pairs of two shells, in the order of ab
+std::vector<HermitePair> hermite_pairs(const Shell &a, const Shell &b,
+                                       const ShellPair &ab);
+
+// McMurchie-Davidson two-electron integrals of a shell quartet,
+// with the Hermite pairs of (ab| and |cd) given
+void int_repulsion(EriClass &eri,
+                   const Shell &a, const Shell &b,
+                   const Shell &c, const Shell &d,
+                   const std::vector<HermitePair> &bra,
+                   const std::vector<HermitePair> &ket,
+                   const nhfBoys::BoysEvaluator &boys = nhfBoys::boys_taylor());
+
+// the same, the Hermite pairs are built from the shell pairs
+void int_repulsion(EriClass &eri,
+                   const Shell &a, const Shell &b,
+                   const Shell &c, const Shell &d,
+                   const ShellPair &ab, const ShellPair &cd,
+                   const nhfBoys::BoysEvaluator &boys = nhfBoys::boys_taylor());
+
+// the same, the shell pairs are built for this quartet
+void int_repulsion(EriClass &eri,
+                   const Shell &a, const Shell &b,
+                   const Shell &c, const Shell &d);
+
+}   // namespace (md)
+}   // namespace (nhfInt)
@@ -0,0 +1,551 @@
+#include "rys_int.hpp"
+#include "cartesian.hpp"
+#include "constant.hpp"
+#include <Eigen/Dense>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <cassert>
+#include <cstddef>
+
+namespace nhfInt {
+namespace rys {
+
+using nhfMath::Vec3d;
+
+namespace {
+
+// number of Gauss-Legendre nodes used to discretize exp(-x t^2) on [0,1]
+const int NUM_LEGENDRE = 96;
+
+// nodes and weights of a Gauss quadrature
+struct NodeTable {
+    std::vector<double> node, weight;
+};
+
+// Golub-Welsch: the nodes are the eigenvalues of the Jacobi matrix.
+// The eigenvalues are only accurate relative to the largest node, so each
+// node is polished by Newton steps on the three-term recurrence, and the
+// weights come from the Christoffel numbers mu0 / sum_k p_k(node)^2 which
+// keep their relative accuracy even when they are tiny.
+// MaxN is the capacity of the matrices, they live on the stack.
+template <int MaxN>
+void golub_welsch(int n, const double *diag, const double *offDiag,
+                  double mu0, double *node, double *weight) {
+    using TriMatrix = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, 0, MaxN, MaxN>;
+    using TriVector = Eigen::Matrix<double, Eigen::Dynamic, 1, 0, MaxN, 1>;
+
+    assert(n <= MaxN);
+    TriVector d(n), e(n > 1 ? n - 1 : 0);
+    for (int i = 0; i < n; ++i) d(i) = diag[i];
+    for (int i = 0; i + 1 < n; ++i) e(i) = offDiag[i];
+
+    Eigen::SelfAdjointEigenSolver<TriMatrix> solver;
+    solver.computeFromTridiagonal(d, e, Eigen::EigenvaluesOnly);
+
+    for (int i = 0; i < n; ++i) {
+        double x = solver.eigenvalues()(i);
+        double sum2 = 0.0;
+        for (int iter = 0; iter < 3; ++iter) {
+            // orthonormal p_k(x) and p_k'(x), p_n is left unnormalized
+            double p0 = 0.0, p1 = 1.0, dp0 = 0.0, dp1 = 0.0;
+            sum2 = 1.0;
+            for (int k = 0; k < n; ++k) {
+                double b0 = k > 0 ? offDiag[k-1] : 0.0;
+                double b1 = k + 1 < n ? offDiag[k] : 1.0;
+                double p2 = ((x - diag[k]) * p1 - b0 * p0) / b1;
+                double dp2 = ((x - diag[k]) * dp1 + p1 - b0 * dp0) / b1;
+                p0 = p1; p1 = p2; dp0 = dp1; dp1 = dp2;
+                if (k + 1 < n) sum2 += p1 * p1;
+            }
+            if (dp1 != 0.0) x -= p1 / dp1;
+        }
+        node[i] = x;
+        weight[i] = mu0 / sum2;
+    }
+}
+
+// Gauss-Legendre on [0,1]
+NodeTable build_legendre_table() {
+    int n = NUM_LEGENDRE;
+    std::vector<double> diag(n, 0.0), offDiag(n, 0.0);
+    for (int k = 1; k < n; ++k) {
+        offDiag[k-1] = k / std::sqrt(4.0 * k * k - 1.0);
+    }
+
+    NodeTable table;
+    table.node = std::vector<double>(n, 0.0);
+    table.weight = std::vector<double>(n, 0.0);
+    golub_welsch<NUM_LEGENDRE>(n, diag.data(), offDiag.data(), 2.0,
+                 table.node.data(), table.weight.data());
+    for (int i = 0; i < n; ++i) {
+        table.node[i] = 0.5 * (table.node[i] + 1.0);
+        table.weight[i] *= 0.5;
+    }
+    return table;
+}
+
+// positive nodes of the Gauss-Hermite rule of order 2n, n = 1 ~ MAX_ROOTS
+std::vector<NodeTable> build_hermite_table() {
+    std::vector<NodeTable> table(MAX_ROOTS + 1);
+    for (int n = 1; n <= MAX_ROOTS; ++n) {
+        int n2 = 2 * n;
+        std::vector<double> diag(n2, 0.0), offDiag(n2, 0.0);
+        std::vector<double> node(n2, 0.0), weight(n2, 0.0);
+        for (int k = 1; k < n2; ++k) {
+            offDiag[k-1] = std::sqrt(0.5 * k);
+        }
+        golub_welsch<2 * MAX_ROOTS>(n2, diag.data(), offDiag.data(), std::sqrt(nhfMath::PI),
+                     node.data(), weight.data());
+
+        // eigenvalues are ascending, the positive half comes last
+        table[n].node.assign(node.begin() + n, node.end());
+        table[n].weight.assign(weight.begin() + n, weight.end());
+    }
+    return table;
+}
+
+const NodeTable& legendre_table() {
+    static const NodeTable table = build_legendre_table();
+    return table;
+}
+
+const NodeTable& hermite_table(int n) {
+    static const std::vector<NodeTable> table = build_hermite_table();
+    return table[n];
+}
+
+// beyond this x, [0,1] can be replaced by [0,inf) in the Rys weight
+// function and the roots follow from the Gauss-Hermite rule
+double asymptotic_x(int n) {
+    return 33.0 + 5.0 * n;
+}
+
+// Rys roots and weights of order n at x <= asymptotic_x(n) by Lanczos
+// (discretized Stieltjes) on the measure exp(-x t^2) dt, written in
+// u = t^2, which gives the Jacobi matrix of the Rys polynomials. Too slow
+// for every primitive quartet, it only fills the RootTable.
+void rys_roots_lanczos(int n, double x, double *root, double *weight) {
+    const NodeTable &table = legendre_table();
+    double u[NUM_LEGENDRE], w[NUM_LEGENDRE];
+    double q0[NUM_LEGENDRE], q1[NUM_LEGENDRE];
+
+    double mu0 = 0.0;
+    for (int j = 0; j < NUM_LEGENDRE; ++j) {
+        u[j] = table.node[j] * table.node[j];
+        w[j] = table.weight[j] * std::exp(-x * u[j]);
+        mu0 += w[j];
+    }
+
+    double diag[MAX_ROOTS], offDiag[MAX_ROOTS];
+    double invNorm = 1.0 / std::sqrt(mu0);
+    for (int j = 0; j < NUM_LEGENDRE; ++j) {
+        q0[j] = 0.0;
+        q1[j] = invNorm;
+    }
+
+    double beta = 0.0;
+    for (int k = 0; k < n; ++k) {
+        double alpha = 0.0;
+        for (int j = 0; j < NUM_LEGENDRE; ++j) {
+            alpha += w[j] * u[j] * q1[j] * q1[j];
+        }
+        diag[k] = alpha;
+        if (k + 1 == n) break;
+
+        double norm2 = 0.0;
+        for (int j = 0; j < NUM_LEGENDRE; ++j) {
+            double r = (u[j] - alpha) * q1[j] - beta * q0[j];
+            q0[j] = q1[j];
+            q1[j] = r;
+            norm2 += w[j] * r * r;
+        }
+        beta = std::sqrt(norm2);
+        offDiag[k] = beta;
+        for (int j = 0; j < NUM_LEGENDRE; ++j) {
+            q1[j] /= beta;
+        }
+    }
+
+    golub_welsch<MAX_ROOTS>(n, diag, offDiag, mu0, root, weight);
+}
+
+// Piecewise Chebyshev interpolation of the roots and weights of order n
+// on 0 <= x <= asymptotic_x(n), as BoysChebyshev does for the Boys
+// function: equal intervals, a Chebyshev series of ROOT_DEGREE per root
+// and weight on each. The intervals are halved until every root and
+// weight between the nodes is within a relative ROOT_TOL of
+// rys_roots_lanczos.
+class RootTable {
+public:
+    static const int ROOT_DEGREE  = 13;
+    static const int MAX_INTERVAL = 1024;
+
+    explicit RootTable(int n);
+
+    void eval(double x, double *root, double *weight) const;
+
+private:
+    int                 n;
+    int                 nInterval;
+    double              width, invWidth;
+    std::vector<double> coef;   // [(interval * (ROOT_DEGREE+1) + k) * 2n + r],
+                                // r < n the roots, r >= n the weights
+
+    // coefficients on nInt intervals, returns the largest relative error
+    // at the points halfway between the nodes
+    double build(int nInt);
+};
+
+const double ROOT_TOL = 1e-13;
+
+RootTable::RootTable(int n)
+: n(n), nInterval(0), width(0.0), invWidth(0.0) {
+    int nInt = int(std::ceil(asymptotic_x(n) / 4.0));
+    while (build(nInt) > ROOT_TOL && nInt < MAX_INTERVAL) {
+        nInt *= 2;
+    }
+}
+
+double RootTable::build(int nInt) {
+    const int d = ROOT_DEGREE;
+    const double PI = nhfMath::PI;
+    nInterval = nInt;
+    width = asymptotic_x(n) / nInt;
+    invWidth = 1.0 / width;
+
+    // c_k = 2/(d+1) sum_j f(t_j) T_k(t_j) on the Chebyshev nodes
+    // t_j = cos(theta_j), theta_j = pi (j+1/2) / (d+1), c_0 is halved
+    std::size_t nc = d + 1, nRow = 2 * n;
+    coef.assign(std::size_t(nInt) * nc * nRow, 0.0);
+    double f[2 * MAX_ROOTS];
+    for (int i = 0; i < nInt; ++i) {
+        double *c = &coef[std::size_t(i) * nc * nRow];
+        for (int j = 0; j <= d; ++j) {
+            double theta = PI * (j + 0.5) / (d + 1);
+            rys_roots_lanczos(n, (i + 0.5 * (std::cos(theta) + 1.0)) * width, f, f + n);
+            for (std::size_t k = 0; k < nc; ++k) {
+            for (std::size_t r = 0; r < nRow; ++r) {
+                c[k * nRow + r] += 2.0 / (d + 1) * f[r] * std::cos(k * theta);
+            }}
+        }
+        for (std::size_t r = 0; r < nRow; ++r) {
+            c[r] *= 0.5;
+        }
+    }
+
+    // the interpolation error peaks between the nodes, at the extrema
+    // t = cos(pi j / (d+1)) of T_(d+1)
+    double err = 0.0, val[2 * MAX_ROOTS];
+    for (int i = 0; i < nInt; ++i) {
+        for (int j = 0; j <= d + 1; ++j) {
+            double x = (i + 0.5 * (std::cos(PI * j / (d + 1)) + 1.0)) * width;
+            rys_roots_lanczos(n, x, f, f + n);
+            eval(x, val, val + n);
+            for (std::size_t r = 0; r < nRow; ++r) {
+                err = std::max(err, std::fabs(val[r] - f[r]) / f[r]);
+            }
+        }
+    }
+    return err;
+}
+
+void RootTable::eval(double x, double *root, double *weight) const {
+    int i = std::min(int(x * invWidth), nInterval - 1);
+    double t = 2.0 * (x * invWidth - i) - 1.0;
+    int nRow = 2 * n;
+    const double *c = &coef[std::size_t(i) * (ROOT_DEGREE + 1) * nRow];
+
+    // Clenshaw on all roots and weights at once, they share t
+    double b1[2 * MAX_ROOTS], b2[2 * MAX_ROOTS];
+    for (int r = 0; r < nRow; ++r) {
+        b1[r] = c[ROOT_DEGREE * nRow + r];
+        b2[r] = 0.0;
+    }
+    for (int k = ROOT_DEGREE - 1; k > 0; --k) {
+        const double *ck = c + k * nRow;
+        for (int r = 0; r < nRow; ++r) {
+            double b0 = ck[r] + 2.0 * t * b1[r] - b2[r];
+            b2[r] = b1[r];
+            b1[r] = b0;
+        }
+    }
+    for (int r = 0; r < n; ++r) {
+        root[r] = c[r] + t * b1[r] - b2[r];
+        weight[r] = c[n + r] + t * b1[n + r] - b2[n + r];
+    }
+}
+
+// the RootTable of order n, built on the first call for n
+const RootTable& root_table(int n) {
+    static std::unique_ptr<RootTable> table[MAX_ROOTS + 1];
+    static std::once_flag once[MAX_ROOTS + 1];
+    std::call_once(once[n], [n]() { table[n].reset(new RootTable(n)); });
+    return *table[n];
+}
+
+// the 1D integrals I(i,j,k,l), i <= La, j <= Lb, k <= Lc, l <= Ld, are
+// obtained from G(n,m), n <= La+Lb, m <= Lc+Ld by the transfer equation
+//   I(i,j+1,k,l) = I(i+1,j,k,l) + AB I(i,j,k,l)
+//   I(i,j,k,l+1) = I(i,j,k+1,l) + CD I(i,j,k,l)
+const int MAX_1D = 2 * 6 + 1;
+
+void rys_2d(int Lab, int Lcd, double B00, double B10, double B01,
+            double C00, double D00, double G[][MAX_1D]) {
+    G[0][0] = 1.0;
+    if (Lab > 0) G[1][0] = C00;
+    for (int n = 1; n < Lab; ++n) {
+        G[n+1][0] = C00 * G[n][0] + n * B10 * G[n-1][0];
+    }
+
+    for (int m = 0; m < Lcd; ++m) {
+        for (int n = 0; n <= Lab; ++n) {
+            double val = D00 * G[n][m];
+            if (m > 0) val += m * B01 * G[n][m-1];
+            if (n > 0) val += n * B00 * G[n-1][m];
+            G[n][m+1] = val;
+        }
+    }
+}
+
+void rys_transfer(int La, int Lb, int Lc, int Ld, double AB, double CD,
+                  const double G[][MAX_1D], double *I) {
+    int Lab = La + Lb, Lcd = Lc + Ld;
+
+    // K[n][k][l] from G[n][m]
+    double K[MAX_1D][MAX_1D][MAX_1D];
+    for (int n = 0; n <= Lab; ++n) {
+        for (int m = 0; m <= Lcd; ++m) {
+            K[n][m][0] = G[n][m];
+        }
+        for (int l = 1; l <= Ld; ++l) {
+        for (int k = 0; k <= Lcd - l; ++k) {
+            K[n][k][l] = K[n][k+1][l-1] + CD * K[n][k][l-1];
+        }}
+    }
+
+    double H[MAX_1D][MAX_1D];
+    for (int k = 0; k <= Lc; ++k) {
+    for (int l = 0; l <= Ld; ++l) {
+        for (int n = 0; n <= Lab; ++n) {
+            H[n][0] = K[n][k][l];
+        }
+        for (int j = 1; j <= Lb; ++j) {
+        for (int i = 0; i <= Lab - j; ++i) {
+            H[i][j] = H[i+1][j-1] + AB * H[i][j-1];
+        }}
+
+        for (int i = 0; i <= La; ++i) {
+        for (int j = 0; j <= Lb; ++j) {
+            I[((i * (Lb+1) + j) * (Lc+1) + k) * (Ld+1) + l] = H[i][j];
+        }}
+    }}
+}
+
+// quantities of one primitive quartet shared by every root
+struct PrimQuartet {
+    double zeta, eta, rho, pre, T;
+    double PA[3], QC[3], PQ[3];
+};
+
+// the primitive quartet of bra pair (zeta, P, Kab) and ket pair (eta, Q, Kcd)
+PrimQuartet prim_quartet(double zeta, const Vec3d &P, double Kab, const Vec3d &A,
+                         double eta, const Vec3d &Q, double Kcd, const Vec3d &C) {
+    PrimQuartet q;
+    q.zeta = zeta;
+    q.eta = eta;
+    q.rho = q.zeta * q.eta / (q.zeta + q.eta);
+
+    for (std::size_t i = 0; i < 3; ++i) {
+        q.PA[i] = P[i] - A[i];
+        q.QC[i] = Q[i] - C[i];
+        q.PQ[i] = P[i] - Q[i];
+    }
+    q.T = q.rho * (P - Q).len2();
+
+    q.pre = 2.0 * std::pow(nhfMath::PI, 2.5)
+          / (q.zeta * q.eta * std::sqrt(q.zeta + q.eta)) * Kab * Kcd;
+    return q;
+}
+
+// 1D integrals of all directions at one root, stored as I[dir][ijkl]
+void rys_1d(const PrimQuartet &q, double u, int La, int Lb, int Lc, int Ld,
+            const double *AB, const double *CD, double *I) {
+    double sumZE = q.zeta + q.eta;
+    double B00 = 0.5 * u / sumZE;
+    double B10 = 0.5 / q.zeta * (1.0 - q.eta / sumZE * u);
+    double B01 = 0.5 / q.eta * (1.0 - q.zeta / sumZE * u);
+
+    std::size_t n1D = (La+1) * (Lb+1) * (Lc+1) * (Ld+1);
+    double G[MAX_1D][MAX_1D];
+    for (int dir = 0; dir < 3; ++dir) {
+        double C00 = q.PA[dir] - q.eta / sumZE * u * q.PQ[dir];
+        double D00 = q.QC[dir] + q.zeta / sumZE * u * q.PQ[dir];
+        rys_2d(La + Lb, Lc + Ld, B00, B10, B01, C00, D00, G);
+        rys_transfer(La, Lb, Lc, Ld, AB[dir], CD[dir], G, I + dir * n1D);
+    }
+}
+
+// scratch of int_repulsion, per thread and only growing, so a loop of
+// ERI calls allocates only until it has seen its largest class
+struct RysScratch {
+    std::vector<std::size_t> off;   // offX, offY, offZ of the components
+    std::vector<double>      I;     // 1D integrals of every root
+};
+
+RysScratch& thread_scratch() {
+    static thread_local RysScratch scratch;
+    return scratch;
+}
+
+}   // namespace (anonymous)
+
+
+void rys_roots(int n, double x, double *root, double *weight) {
+    assert(n >= 1 && n <= MAX_ROOTS);
+
+    if (x > asymptotic_x(n)) {
+        const NodeTable &table = hermite_table(n);
+        double invSqrtX = 1.0 / std::sqrt(x);
+        for (int i = 0; i < n; ++i) {
+            root[i] = table.node[i] * table.node[i] / x;
+            weight[i] = table.weight[i] * invSqrtX;
+        }
+        return;
+    }
+    root_table(n).eval(x, root, weight);
+}
+
+
+double gauss_int_repulsion(double alpha1, int l1, int m1, int n1, double x1, double y1, double z1,
+                           double alpha2, int l2, int m2, int n2, double x2, double y2, double z2,
+                           double alpha3, int l3, int m3, int n3, double x3, double y3, double z3,
+                           double alpha4, int l4, int m4, int n4, double x4, double y4, double z4)
+{
+    Vec3d A(x1, y1, z1), B(x2, y2, z2), C(x3, y3, z3), D(x4, y4, z4);
+    double zeta = alpha1 + alpha2, eta = alpha3 + alpha4;
+    PrimQuartet q = prim_quartet(
+        zeta, (alpha1 * A + alpha2 * B) / zeta,
+        std::exp(-alpha1 * alpha2 / zeta * (A - B).len2()), A,
+        eta, (alpha3 * C + alpha4 * D) / eta,
+        std::exp(-alpha3 * alpha4 / eta * (C - D).len2()), C);
+
+    double AB[3] = {x1 - x2, y1 - y2, z1 - z2};
+    double CD[3] = {x3 - x4, y3 - y4, z3 - z4};
+    int lmn[3][4] = {{l1, l2, l3, l4}, {m1, m2, m3, m4}, {n1, n2, n3, n4}};
+
+    int nRoots = (l1+l2+l3+l4 + m1+m2+m3+m4 + n1+n2+n3+n4) / 2 + 1;
+    double root[MAX_ROOTS], weight[MAX_ROOTS];
+    rys_roots(nRoots, q.T, root, weight);
+
+    double sumZE = q.zeta + q.eta;
+    double ret = 0.0;
+    for (int r = 0; r < nRoots; ++r) {
+        double u = root[r];
+        double val = weight[r];
+        for (int dir = 0; dir < 3; ++dir) {
+            const int *l = lmn[dir];
+            double G[MAX_1D][MAX_1D];
+            rys_2d(l[0] + l[1], l[2] + l[3],
+                   0.5 * u / sumZE,
+                   0.5 / q.zeta * (1.0 - q.eta / sumZE * u),
+                   0.5 / q.eta * (1.0 - q.zeta / sumZE * u),
+                   q.PA[dir] - q.eta / sumZE * u * q.PQ[dir],
+                   q.QC[dir] + q.zeta / sumZE * u * q.PQ[dir], G);
+
+            // I(l1,l2,l3,l4) is the last element of the transfer table
+            double I[7 * 7 * 7 * 7];
+            rys_transfer(l[0], l[1], l[2], l[3], AB[dir], CD[dir], G, I);
+            val *= I[(l[0]+1) * (l[1]+1) * (l[2]+1) * (l[3]+1) - 1];
+        }
+        ret += val;
+    }
+
+    return q.pre * ret;
+}
+
+
+void int_repulsion(EriClass &eri,
+                   const Shell &a, const Shell &b,
+                   const Shell &c, const Shell &d,
+                   const ShellPair &ab, const ShellPair &cd) {
+    eri.reset(a.L, b.L, c.L, d.L);
+
+    const Vec3d &A = a.centre, &C = c.centre;
+    double AB[3] = {ab.AB.x, ab.AB.y, ab.AB.z};
+    double CD[3] = {cd.AB.x, cd.AB.y, cd.AB.z};
+
+    int nRoots = (a.L + b.L + c.L + d.L) / 2 + 1;
+    std::size_t nb = b.L + 1, nc = c.L + 1, nd = d.L + 1;
+    std::size_t n1D = (a.L + 1) * nb * nc * nd;
+    auto idx1D = [nb, nc, nd](int l1, int l2, int l3, int l4) -> std::size_t
+    { return ((l1 * nb + l2) * nc + l3) * nd + l4; };
+
+    // position of every component in the 1D tables
+    RysScratch &scratch = thread_scratch();
+    scratch.off.resize(3 * eri.size());
+    std::size_t *offX = scratch.off.data();
+    std::size_t *offY = offX + eri.size(), *offZ = offY + eri.size();
+    for (std::size_t ia = 0; ia < a.size(); ++ia) {
+    for (std::size_t ib = 0; ib < b.size(); ++ib) {
+    for (std::size_t ic = 0; ic < c.size(); ++ic) {
+    for (std::size_t id = 0; id < d.size(); ++id) {
+        const AngMom &ma = a.ijk[ia], &mb = b.ijk[ib];
+        const AngMom &mc = c.ijk[ic], &md = d.ijk[id];
+        std::size_t idx = ((ia * b.size() + ib) * c.size() + ic) * d.size() + id;
+        offX[idx] = idx1D(ma.i, mb.i, mc.i, md.i);
+        offY[idx] = idx1D(ma.j, mb.j, mc.j, md.j) + n1D;
+        offZ[idx] = idx1D(ma.k, mb.k, mc.k, md.k) + 2 * n1D;
+    }}}}
+
+    scratch.I.resize(3 * n1D * nRoots);
+    double *I = scratch.I.data();
+    double root[MAX_ROOTS], weight[MAX_ROOTS];
+
+    for (std::size_t kab = 0; kab < ab.nprim(); ++kab) {
+    for (std::size_t kcd = 0; kcd < cd.nprim(); ++kcd) {
+        PrimQuartet q = prim_quartet(ab.zeta[kab], ab.P(kab), ab.K[kab], A,
+                                     cd.zeta[kcd], cd.P(kcd), cd.K[kcd], C);
+        double pre = q.pre;
+
+        rys_roots(nRoots, q.T, root, weight);
+        for (int r = 0; r < nRoots; ++r) {
+            double *Ir = &I[3 * n1D * r];
+            rys_1d(q, root[r], a.L, b.L, c.L, d.L, AB, CD, Ir);
+
+            // fold weight and prefactor into the x table
+            for (std::size_t i = 0; i < n1D; ++i) {
+                Ir[i] *= pre * weight[r];
+            }
+        }
+
+        for (std::size_t idx = 0; idx < eri.size(); ++idx) {
+            double sum = 0.0;
+            for (int r = 0; r < nRoots; ++r) {
+                const double *Ir = &I[3 * n1D * r];
+                sum += Ir[offX[idx]] * Ir[offY[idx]] * Ir[offZ[idx]];
+            }
+            eri.eriVal[idx] += sum;
+        }
+    }}
+
+    for (std::size_t ia = 0; ia < a.size(); ++ia) {
+    for (std::size_t ib = 0; ib < b.size(); ++ib) {
+    for (std::size_t ic = 0; ic < c.size(); ++ic) {
+    for (std::size_t id = 0; id < d.size(); ++id) {
+        eri(ia, ib, ic, id) *= a.scale[ia] * b.scale[ib]
+                             * c.scale[ic] * d.scale[id];
+    }}}}
+}
+
+
+void int_repulsion(EriClass &eri,
+                   const Shell &a, const Shell &b,
+                   const Shell &c, const Shell &d) {
+    rys::int_repulsion(eri, a, b, c, d, ShellPair(a, b), ShellPair(c, d));
+}
+
+}   // namespace (rys)
+}   // namespace (nhfInt)
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "tho_basis.hpp"
+#include "eri_class.hpp"
+
+namespace nhfInt {
+namespace rys {
+
+using tho::Shell;
+using tho::ShellPair;
+
+// largest number of roots, enough for (ii|ii)
+const int MAX_ROOTS = 13;
+
+// Rys roots and weights of order n at x:
+//   F_k(x) = sum_i weight[i] * root[i]^k,   k = 0 ~ 2n-1
+// the roots are t^2 of the Rys polynomials, they lie in (0,1). They are
+// interpolated in tables of x built on the first call for n, for large x
+// they follow from the Gauss-Hermite rule.
+void rys_roots(int n, double x, double *root, double *weight);
+
+// Dupuis-King-Rys quadrature, same arguments as tho::gauss_int_repulsion
+double gauss_int_repulsion(double alpha1, int l1, int m1, int n1, double x1, double y1, double z1,
+                           double alpha2, int l2, int m2, int n2, double x2, double y2, double z2,
+                           double alpha3, int l3, int m3, int n3, double x3, double y3, double z3,
+                           double alpha4, int l4, int m4, int n4, double x4, double y4, double z4);
+
+// all Cartesian components of (ab|cd), the 2D integrals of every
+// primitive quartet and root are shared between the components.
+void int_repulsion(EriClass &eri,
+                   const Shell &a, const Shell &b,
+                   const Shell &c, const Shell &d,
+                   const ShellPair &ab, const ShellPair &cd);
+
+// the same, the shell pairs are built for this quartet
+void int_repulsion(EriClass &eri,
+                   const Shell &a, const Shell &b,
+                   const Shell &c, const Shell &d);
+
+}   // namespace (rys)
+}   // namespace (nhfInt)
@@ -0,0 +1,35 @@
+#include "scheduler.hpp"
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <cassert>
+
+namespace nhfInt {
+
+double pair_cost(const tho::Shell &a, const tho::Shell &b, const tho::ShellPair &ab) {
+    return double(ab.nprim()) * double(a.size() * b.size());
+}
+
+TaskPlan::TaskPlan(const std::vector<double> &cost, int nThread)
+: nThread(nThread), bound(1, 0) {
+    assert(nThread > 0);
+
+    double total = std::accumulate(cost.begin(), cost.end(), 0.0);
+    double target = total / (double(CHUNKS_PER_THREAD) * nThread);
+    double acc = 0.0;
+    for (std::size_t t = 0; t < cost.size(); ++t) {
+        acc += cost[t];
+        if (acc >= target || t + 1 == cost.size()) {
+            bound.push_back(t + 1);
+            chunkCost.push_back(acc);
+            acc = 0.0;
+        }
+    }
+
+    order.resize(chunkCost.size());
+    std::iota(order.begin(), order.end(), std::size_t(0));
+    std::stable_sort(order.begin(), order.end(),
+        [this](std::size_t x, std::size_t y) { return chunkCost[x] > chunkCost[y]; });
+}
+
+}   // namespace (nhfInt)
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "tho_basis.hpp"
+#include <vector>
+#include <cstddef>
+#ifdef NHFINT_OPENMP
+#include <omp.h>
+#endif
+
+namespace nhfInt {
+
+// Rough cost of the integrals of a shell pair, the primitive pairs left
+// after screening times the Cartesian components. The cost of a quartet
+// (ab|cd) is pair_cost(ab) * pair_cost(cd), the number of primitive
+// quartets times the components of the class.
+double pair_cost(const tho::Shell &a, const tho::Shell &b, const tho::ShellPair &ab);
+
+
+// A loop over n tasks of known cost, cut into chunks of consecutive tasks
+// of about total / (CHUNKS_PER_THREAD * nThread) cost each. The threads
+// take the chunks from a shared counter, the most expensive first, so a
+// few (dd|dd) rows do not end up behind a long tail of (ss|ss) rows and
+// many cheap tasks do not each cost a trip to the counter.
+class TaskPlan {
+public:
+    static const int CHUNKS_PER_THREAD = 8;
+
+    TaskPlan(const std::vector<double> &cost, int nThread);
+
+    int         n_thread() const { return nThread; }
+    std::size_t size()     const { return order.size(); }   // chunks
+
+    // tasks [first(k), last(k)) of the k-th chunk to run
+    std::size_t first(std::size_t k) const { return bound[order[k]]; }
+    std::size_t last(std::size_t k)  const { return bound[order[k] + 1]; }
+    double      cost(std::size_t k)  const { return chunkCost[order[k]]; }
+
+private:
+    int                      nThread;
+    std::vector<std::size_t> bound;      // chunk c is [bound[c], bound[c+1])
+    std::vector<double>      chunkCost;
+    std::vector<std::size_t> order;      // chunks by decreasing cost
+};
+
+
+// worker[t](task) for every task of plan, worker[t] on thread t, so that
+// each worker can keep its own buffers and partial sums. worker has
+// plan.n_thread() entries.
+template <class Worker>
+void run_tasks(const TaskPlan &plan, std::vector<Worker> &worker) {
+#ifdef NHFINT_OPENMP
+    #pragma omp parallel num_threads(plan.n_thread())
+    {
+        Worker &w = worker[omp_get_thread_num()];
+        #pragma omp for schedule(dynamic, 1)
+        for (std::size_t k = 0; k < plan.size(); ++k) {
+            for (std::size_t t = plan.first(k); t < plan.last(k); ++t) {
+                w(t);
+            }
+        }
+    }
+#else
+    for (std::size_t k = 0; k < plan.size(); ++k) {
+        for (std::size_t t = plan.first(k); t < plan.last(k); ++t) {
+            worker[0](t);
+        }
+    }
+#endif
+}
+
+}   // namespace (nhfInt)
@@ -0,0 +1,115 @@
+#include "spherical.hpp"
+#include "cartesian.hpp"
+#include "mathfun.hpp"
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <cassert>
+
+namespace nhfInt {
+
+namespace {
+
+using nhfMath::semifactorial;
+using nhfMath::combination;
+
+// <x^i y^j z^k | x^i' y^j' z^k'> over the same radial Gaussian, relative
+// to <x^L | x^L>
+double monomial_overlap(const AngMom &p, const AngMom &q, int L) {
+    int i = p.i + q.i, j = p.j + q.j, k = p.k + q.k;
+    if (i % 2 != 0 || j % 2 != 0 || k % 2 != 0) return 0.0;
+    return semifactorial(i - 1) * semifactorial(j - 1) * semifactorial(k - 1)
+         / semifactorial(2 * L - 1);
+}
+
+// S_Lm as a polynomial (Helgaker, Jorgensen, Olsen, eq. 6.4.47),
+//     S_Lm = sum_tuv C_tuv x^(2t+|m|-2u-2v) y^(2u+2v) z^(L-2t-|m|)
+// with v = 0, 1, ... for m >= 0 and v = 1/2, 3/2, ... for m < 0, here
+// w = 2v. The norm comes from the monomial overlaps.
+std::vector<double> build_transform(int L) {
+    const std::vector<AngMom> &cart = cart_list(L);
+    std::size_t nc = cart.size();
+    std::vector<double> T(num_pure(L) * nc, 0.0);
+
+    for (int m = -L; m <= L; ++m) {
+        double *row = &T[(m + L) * nc];
+        int am = std::abs(m), wm = m < 0 ? 1 : 0;
+        for (int t = 0; t <= (L - am) / 2; ++t) {
+        for (int u = 0; u <= t; ++u) {
+        for (int w = wm; w <= am; w += 2) {
+            double c = std::pow(0.25, t) * combination(L, t) * combination(L - t, am + t)
+                     * combination(t, u) * combination(am, w);
+            if ((t + (w - wm) / 2) % 2 != 0) c = -c;
+            row[index_of_ijk(2*t + am - 2*u - w, 2*u + w, L - 2*t - am)] += c;
+        }}}
+
+        double norm2 = 0.0;
+        for (std::size_t p = 0; p < nc; ++p) {
+        for (std::size_t q = 0; q < nc; ++q) {
+            norm2 += row[p] * row[q] * monomial_overlap(cart[p], cart[q], L);
+        }}
+
+        // the monomials are in units of the (L,0,0) norm, phi_c carries
+        // the component scale of Shell::scale on top of it
+        for (std::size_t c = 0; c < nc; ++c) {
+            double scale = std::sqrt(semifactorial(2 * L - 1) /
+                                     (semifactorial(2 * cart[c].i - 1) *
+                                      semifactorial(2 * cart[c].j - 1) *
+                                      semifactorial(2 * cart[c].k - 1)));
+            row[c] /= std::sqrt(norm2) * scale;
+        }
+    }
+    return T;
+}
+
+}   // namespace (anonymous)
+
+
+const std::vector<double>& cart_to_pure(int L) {
+    assert(L >= 0 && L <= 6);
+    static const std::vector<double> table[] = {
+        build_transform(0), build_transform(1), build_transform(2),
+        build_transform(3), build_transform(4), build_transform(5),
+        build_transform(6)
+    };
+    return table[L];
+}
+
+void block_to_pure(std::vector<double> &val, const tho::Shell *const *sh,
+                   std::size_t n, std::vector<double> &tmp) {
+    // dims[k] is the Cartesian size of shell k until index k is done
+    std::size_t dims[4];
+    assert(n <= 4);
+    for (std::size_t k = 0; k < n; ++k) {
+        dims[k] = sh[k]->size();
+    }
+
+    for (std::size_t k = 0; k < n; ++k) {
+        if (!sh[k]->pure) continue;
+
+        std::size_t outer = 1, inner = 1;
+        for (std::size_t i = 0; i < k; ++i) outer *= dims[i];
+        for (std::size_t i = k + 1; i < n; ++i) inner *= dims[i];
+        std::size_t nc = dims[k], np = sh[k]->nfunc();
+        assert(val.size() == outer * nc * inner);
+
+        const std::vector<double> &T = cart_to_pure(sh[k]->L);
+        tmp.assign(outer * np * inner, 0.0);
+        for (std::size_t o = 0; o < outer; ++o) {
+            const double *src = &val[o * nc * inner];
+            double *dst = &tmp[o * np * inner];
+            for (std::size_t p = 0; p < np; ++p) {
+            for (std::size_t c = 0; c < nc; ++c) {
+                double t = T[p * nc + c];
+                if (t == 0.0) continue;
+                for (std::size_t i = 0; i < inner; ++i) {
+                    dst[p * inner + i] += t * src[c * inner + i];
+                }
+            }}
+        }
+        val.swap(tmp);
+        dims[k] = np;
+    }
+}
+
+}   // namespace (nhfInt)
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "tho_basis.hpp"
+#include <vector>
+#include <cstddef>
+
+namespace nhfInt {
+
+// number of real solid harmonics of angular momentum L
+inline std::size_t num_pure(int L) {
+    return 2 * L + 1;
+}
+
+// The real solid harmonics S_Lm, m = -L ~ L, in terms of the normalized
+// Cartesian components phi_c of generate_angmom(L):
+//     S_Lm = sum_c T[(m + L) * num_cart(L) + c] phi_c
+// S_Lm has the same radial part as phi_c and is normalized.
+const std::vector<double>& cart_to_pure(int L);
+
+// Transform a row-major block over the Cartesian components of the
+// shells sh[0] ~ sh[n-1], e.g. [a][b] or [a][b][c][d], in place to the
+// functions of the shells. The indices of shells that are not pure are
+// left as they are, tmp is scratch memory.
+void block_to_pure(std::vector<double> &val, const tho::Shell *const *sh,
+                   std::size_t n, std::vector<double> &tmp);
+
+}   // namespace (nhfInt)
@@ -1,12 +1,29 @@
 #include "tho_basis.hpp"
 #include "tho_int.hpp"
+#include "boysfun.hpp"
+#include "boys_chebyshev.hpp"
+#include "hgp_int.hpp"
+#include "rys_int.hpp"
+#include "md_int.hpp"
+#include "gen_int.hpp"
+#include "spherical.hpp"
+#include "scheduler.hpp"
+#include "fock.hpp"
+#include "eri_file.hpp"
 #include "basisfile.hpp"
 #include "mathfun.hpp"
 #include "constant.hpp"
 #include <vector>
 #include <set>
+#include <cmath>
+#include <algorithm>
+#include <limits>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
+#ifdef NHFINT_OPENMP
+#include <omp.h>
+#endif
 
 namespace nhfInt {
 namespace tho {
@@ -94,6 +111,78 @@ Basis::Basis(
 }
 
 
+/* Shell */
+Shell::Shell(
+        int L,
+        const std::vector<double> &alphaVec,
+        const std::vector<double> &combVec,
+        const Vec3d &centre,
+        std::size_t offset
+) : L(L), centre(centre), alpha(alphaVec), coeff(combVec),
+    ijk(generate_angmom(L)), offset(offset), pure(false), func(offset) {
+    assert(alphaVec.size() == combVec.size());
+
+    for (std::size_t i = 0; i < alpha.size(); ++i) {
+        coeff[i] *= gto_norm_const(alpha[i], L, 0, 0);
+    }
+
+    // gto_norm_const(alpha,l,m,n) / gto_norm_const(alpha,L,0,0)
+    scale = std::vector<double>(ijk.size(), 0.0);
+    for (std::size_t c = 0; c < ijk.size(); ++c) {
+        scale[c] = std::sqrt(nhfMath::semifactorial(2 * L - 1) /
+                             (nhfMath::semifactorial(2 * ijk[c].i - 1) *
+                              nhfMath::semifactorial(2 * ijk[c].j - 1) *
+                              nhfMath::semifactorial(2 * ijk[c].k - 1)));
+    }
+}
+
+
+/* ShellPair */
+ShellPair::ShellPair(const Shell &a, const Shell &b, double thresh)
+: AB(a.centre - b.centre), nScreened(0) {
+    double AB2 = AB.len2();
+    for (std::size_t i = 0; i < a.nprim(); ++i) {
+    for (std::size_t j = 0; j < b.nprim(); ++j) {
+        double alpha1 = a.alpha[i], alpha2 = b.alpha[j];
+        double invZ = 1.0 / (alpha1 + alpha2);
+        double Kab = std::exp(-alpha1 * alpha2 * invZ * AB2)
+                   * a.coeff[i] * b.coeff[j];
+        if (std::abs(Kab) < thresh) {
+            ++nScreened;
+            continue;
+        }
+
+        Vec3d P = (alpha1 * a.centre + alpha2 * b.centre) * invZ;
+        pa.push_back(i);
+        pb.push_back(j);
+        zeta.push_back(alpha1 + alpha2);
+        invZeta.push_back(invZ);
+        Px.push_back(P.x);
+        Py.push_back(P.y);
+        Pz.push_back(P.z);
+        K.push_back(Kab);
+    }}
+}
+
+
+/* ShellPairList */
+ShellPairList::ShellPairList(const std::vector<Shell> &shList, double primThresh)
+: primThresh(primThresh), nPrimPair(0), nPrimScreened(0) {
+    pairs.reserve(shList.size() * (shList.size() + 1) / 2);
+    for (std::size_t i = 0; i < shList.size(); ++i) {
+    for (std::size_t j = 0; j <= i; ++j) {
+        pairs.push_back(ShellPair(shList[i], shList[j], primThresh));
+        nPrimPair += shList[i].nprim() * shList[j].nprim();
+        nPrimScreened += pairs.back().nScreened;
+    }}
+}
+
+const ShellPair& ShellPairList::operator()(std::size_t i, std::size_t j) const {
+    assert(i >= j && idx2(i, j) < pairs.size());
+    return pairs[idx2(i, j)];
+}
+
+
 /* BasisSet */
 Basis  BasisSet::operator[](std::size_t i) const {
     assert(i < bsList.size());
@@ -105,67 +194,473 @@ Basis& BasisSet::operator[](std::size_t i) {
     return bsList[i];
 }
 
-Matrix BasisSet::mat_int_overlap() const {
-    std::size_t nBs = bsList.size();
-    Matrix ret(nBs, nBs, 0.0);
-    for (std::size_t i = 0; i < nBs; ++i) {
-    for (std::size_t j = 0; j <= i; ++j) {
-        ret(i,j) = ret(j,i) = int_overlap(bsList[i], bsList[j]);
+std::size_t BasisSet::n_func() const {
+    std::size_t ret = 0;
+    for (const Shell &sh : shList) {
+        ret += sh.nfunc();
+    }
+    return ret;
+}
+
+// scatter the component block of shell pair (a,b) into a symmetric matrix,
+// pure shells are transformed first
+static void scatter_pair(Matrix &mat, const Shell &a, const Shell &b,
+                         std::vector<double> &val, std::vector<double> &tmp) {
+    const Shell *sh[] = {&a, &b};
+    block_to_pure(val, sh, 2, tmp);
+    for (std::size_t ia = 0; ia < a.nfunc(); ++ia) {
+    for (std::size_t ib = 0; ib < b.nfunc(); ++ib) {
+        mat(a.func + ia, b.func + ib) = mat(b.func + ib, a.func + ia)
+                                      = val[ia * b.nfunc() + ib];
     }}
+}
+
+// a shell pair i >= j
+struct PairIdx {
+    std::size_t i, j;
+};
 
+// the canonical shell pairs of n shells, in the order of idx2
+static std::vector<PairIdx> shell_pairs(std::size_t n) {
+    std::vector<PairIdx> ret;
+    ret.reserve(n * (n + 1) / 2);
+    for (std::size_t i = 0; i < n; ++i) {
+    for (std::size_t j = 0; j <= i; ++j) {
+        ret.push_back({i, j});
+    }}
     return ret;
 }
 
-Matrix BasisSet::mat_int_kinetic() const {
-    std::size_t nBs = bsList.size();
+// the symmetric matrix of a one-electron operator, block(val, i, j) gives
+// the Cartesian block of shell pair (i,j). Every pair writes its own
+// elements, the pairs are spread over the threads by their cost.
+template <class F>
+struct PairWorker {
+    const BasisSet             *bsSet;
+    const std::vector<PairIdx> *pairs;
+    Matrix                     *mat;
+    F                           block;
+    std::vector<double>         val, tmp;
+
+    void operator()(std::size_t k) {
+        std::size_t i = (*pairs)[k].i, j = (*pairs)[k].j;
+        block(val, i, j);
+        scatter_pair(*mat, bsSet->shList[i], bsSet->shList[j], val, tmp);
+    }
+};
+
+template <class F>
+static Matrix pair_matrix(const BasisSet &bsSet, F block) {
+    std::size_t nBs = bsSet.n_func();
+    std::vector<PairIdx> pairs = shell_pairs(bsSet.shList.size());
+
+    std::vector<double> cost;
+    for (const PairIdx &ij : pairs) {
+        cost.push_back(pair_cost(bsSet.shList[ij.i], bsSet.shList[ij.j],
+                                 bsSet.spList(ij.i, ij.j)));
+    }
+    TaskPlan plan(cost, num_threads());
+
     Matrix ret(nBs, nBs, 0.0);
-    for (std::size_t i = 0; i < nBs; ++i) {
-    for (std::size_t j = 0; j <= i; ++j) {
-        ret(i,j) = ret(j,i) = int_kinetic(bsList[i], bsList[j]);
-    }}
+    PairWorker<F> proto = {&bsSet, &pairs, &ret, block, {}, {}};
+    std::vector<PairWorker<F>> worker(plan.n_thread(), proto);
+    run_tasks(plan, worker);
 
     return ret;
 }
 
+Matrix BasisSet::mat_int_overlap() const {
+    return pair_matrix(*this, [this](std::vector<double> &val, std::size_t i, std::size_t j)
+    { int_overlap(val, shList[i], shList[j], spList(i,j)); });
+}
+
+Matrix BasisSet::mat_int_kinetic() const {
+    return pair_matrix(*this, [this](std::vector<double> &val, std::size_t i, std::size_t j)
+    { int_kinetic(val, shList[i], shList[j], spList(i,j)); });
+}
+
 Matrix BasisSet::mat_int_nuclear(const std::vector<int> &zval, 
                              const std::vector<Vec3d> &geom) const {
     assert(zval.size() == geom.size());
 
-    std::size_t nBs = bsList.size();
-    Matrix ret(nBs, nBs, 0.0);
-    for (std::size_t i = 0; i < nBs; ++i) {
-    for (std::size_t j = 0; j <= i; ++j) {
-        double sum = 0.0;
-        for (std::size_t k = 0; k < zval.size(); ++k) {
-            sum += int_nuclear(bsList[i], bsList[j], geom[k]) * zval[k];
+    return pair_matrix(*this, [&](std::vector<double> &val, std::size_t i, std::size_t j)
+    { int_nuclear(val, shList[i], shList[j], spList(i,j), zval, geom); });
+}
+
+// a shell pair (i >= j) and its Schwarz bound
+struct SchwarzPair {
+    double      bound;
+    std::size_t i, j;
+};
+
+// the quartets of bra pair p of pairList, with the ket pairs q <= p down
+// to the first one with Q_p * Q_q < thresh. Quartets with
+// sink.skip(bra, ket) are left out, sink(a, b, c, d, v) gets the others
+// over the functions, in the layout of EriClass::eriVal. For the MD
+// engine hermite[p] holds the Hermite pairs of pairList[p].
+template <class Sink>
+struct RowWorker {
+    const BasisSet                  *bsSet;
+    const std::vector<SchwarzPair>  *pairList;
+    const std::vector<std::vector<md::HermitePair>> *hermite;
+    const EriOption                 *opt;
+    const nhfBoys::BoysEvaluator    *boys;
+    double                           thresh;
+    Sink                             sink;
+    std::size_t nComputed, nSkipped, nPrimQuartet, nPrimComputed;
+    EriClass                         eri;
+    std::vector<double>              val, tmp;
+
+    void operator()(std::size_t p) {
+        const std::vector<SchwarzPair> &pl = *pairList;
+        const std::vector<Shell> &shList = bsSet->shList;
+        const ShellPairList &spList = bsSet->spList;
+
+        for (std::size_t q = 0; q <= p; ++q) {
+            if (pl[p].bound * pl[q].bound < thresh) break;
+
+            const SchwarzPair &bra = pl[p], &ket = pl[q];
+            if (sink.skip(bra, ket)) {
+                ++nSkipped;
+                continue;
+            }
+            const Shell &a = shList[bra.i], &b = shList[bra.j];
+            const Shell &c = shList[ket.i], &d = shList[ket.j];
+            const ShellPair &ab = spList(bra.i, bra.j), &cd = spList(ket.i, ket.j);
+            if (opt->engine == EriEngine::Md) {
+                md::int_repulsion(eri, a, b, c, d, (*hermite)[p], (*hermite)[q], *boys);
+            } else {
+                nhfInt::int_repulsion(opt->engine, eri, a, b, c, d, ab, cd, *boys);
+            }
+            ++nComputed;
+            nPrimQuartet += a.nprim() * b.nprim() * c.nprim() * d.nprim();
+            nPrimComputed += ab.nprim() * cd.nprim();
+
+            // pure shells are transformed on a copy of the Cartesian block
+            const double *v = eri.eriVal.data();
+            if (a.pure || b.pure || c.pure || d.pure) {
+                const Shell *sh[] = {&a, &b, &c, &d};
+                val.assign(eri.eriVal.begin(), eri.eriVal.end());
+                block_to_pure(val, sh, 4, tmp);
+                v = val.data();
+            }
+            sink(a, b, c, d, v);
         }
-        ret(i,j) = ret(j,i) = sum;
+    }
+};
+
+// Every canonical quartet (ab|cd) of bsSet with Q_ab * Q_cd >= thresh,
+// spread over the threads by rows. Returns the workers, one per thread,
+// with their sinks copied from proto.
+template <class Sink>
+static std::vector<RowWorker<Sink>> run_quartets(const BasisSet &bsSet, const EriOption &opt,
+                                                 double thresh, const Sink &proto, EriStat *stat) {
+    const std::vector<Shell> &shList = bsSet.shList;
+    std::size_t nSh = shList.size();
+
+    // shell pairs sorted by decreasing Schwarz bound, so that the ket
+    // loop can stop at the first pair whose bound is too small
+    Matrix Q = bsSet.mat_schwarz(opt.engine);
+    std::vector<SchwarzPair> pairList;
+    for (std::size_t i = 0; i < nSh; ++i) {
+    for (std::size_t j = 0; j <= i; ++j) {
+        pairList.push_back({Q(i,j), i, j});
     }}
+    std::sort(pairList.begin(), pairList.end(),
+        [](const SchwarzPair &x, const SchwarzPair &y)
+        { return x.bound > y.bound; });
+    std::size_t nPair = pairList.size();
 
-    return ret;
+    // the cost of row p is pair_cost(p) times the sum of pair_cost(q) over
+    // its ket pairs, which are a prefix of pairList. nCut counts the ket
+    // pairs that only a thresh above opt.schwarzThresh cuts off.
+    std::vector<double> prefix(1, 0.0), cost(nPair);
+    std::size_t nCut = 0;
+    for (const SchwarzPair &sp : pairList) {
+        prefix.push_back(prefix.back() +
+            pair_cost(shList[sp.i], shList[sp.j], bsSet.spList(sp.i, sp.j)));
+    }
+    for (std::size_t p = 0; p < nPair; ++p) {
+        double bound = pairList[p].bound;
+        std::size_t nKet = std::partition_point(pairList.begin(), pairList.begin() + p + 1,
+            [&](const SchwarzPair &sp) { return bound * sp.bound >= thresh; })
+            - pairList.begin();
+        cost[p] = (prefix[p + 1] - prefix[p]) * prefix[nKet];
+        if (thresh > opt.schwarzThresh) {
+            nCut += std::partition_point(pairList.begin() + nKet, pairList.begin() + p + 1,
+                [&](const SchwarzPair &sp) { return bound * sp.bound >= opt.schwarzThresh; })
+                - pairList.begin() - nKet;
+        }
+    }
+    TaskPlan plan(cost, num_threads());
+
+    // the Hermite expansions of a pair are shared by all of its quartets,
+    // MD builds them once here instead of twice per quartet
+    std::vector<std::vector<md::HermitePair>> hermite;
+    if (opt.engine == EriEngine::Md) {
+        hermite.resize(nPair);
+        for (std::size_t p = 0; p < nPair; ++p) {
+            const SchwarzPair &sp = pairList[p];
+            hermite[p] = md::hermite_pairs(shList[sp.i], shList[sp.j], bsSet.spList(sp.i, sp.j));
+        }
+    }
+
+    // the Schwarz bounds above keep the table, only the integrals use
+    // the evaluator of opt.boysTol
+    const nhfBoys::BoysEvaluator &boys = opt.boysTol > 0.0
+        ? nhfBoys::boys_chebyshev(opt.boysTol) : nhfBoys::boys_taylor();
+
+    RowWorker<Sink> first = {&bsSet, &pairList, &hermite, &opt, &boys, thresh, proto,
+                             0, 0, 0, 0, EriClass(), {}, {}};
+    std::vector<RowWorker<Sink>> worker(plan.n_thread(), first);
+    run_tasks(plan, worker);
+
+    if (stat != nullptr) {
+        std::size_t nComputed = 0, nSkipped = 0, nPrimQuartet = 0, nPrimComputed = 0;
+        for (const RowWorker<Sink> &w : worker) {
+            nComputed += w.nComputed;
+            nSkipped += w.nSkipped;
+            nPrimQuartet += w.nPrimQuartet;
+            nPrimComputed += w.nPrimComputed;
+        }
+        stat->nQuartet = nPair * (nPair + 1) / 2;
+        stat->nScreened = stat->nQuartet - nComputed;
+        stat->nDensityScreened = nCut + nSkipped;
+        stat->nPrimQuartet = nPrimQuartet;
+        stat->nPrimScreened = nPrimQuartet - nPrimComputed;
+    }
+    return worker;
 }
 
-Matrix BasisSet::mat_int_repulsion() const {
-    std::size_t nBs = bsList.size();
+// stores the quartets at idx4 of the functions, the canonical quartets
+// write disjoint elements, so the result does not depend on the threads
+// or on the order of the rows
+struct EriSink {
+    double *ret;
+
+    bool skip(const SchwarzPair &, const SchwarzPair &) const { return false; }
+
+    void operator()(const Shell &a, const Shell &b, const Shell &c, const Shell &d,
+                    const double *v) {
+        std::size_t nb = b.nfunc(), nc = c.nfunc(), nd = d.nfunc();
+        for (std::size_t ia = 0; ia < a.nfunc(); ++ia) {
+        for (std::size_t ib = 0; ib < nb; ++ib) {
+        for (std::size_t ic = 0; ic < nc; ++ic) {
+        for (std::size_t id = 0; id < nd; ++id) {
+            ret[idx4(a.func + ia, b.func + ib,
+                     c.func + ic, d.func + id)] = v[((ia * nb + ib) * nc + ic) * nd + id];
+        }}}}
+    }
+};
+
+Matrix BasisSet::mat_int_repulsion(const EriOption &opt, EriStat *stat) const {
+    std::size_t nBs = n_func();
     std::size_t nEri = idx4(nBs-1, nBs-1, nBs-1, nBs-1) + 1;
 
     Matrix ret(nEri, 1);
-    for (std::size_t i = 0; i < nBs; ++i) {
-    for (std::size_t j = 0; j <= i; ++j) {
-        std::size_t ij = idx2(i, j);
-        for (std::size_t k = 0; k < nBs; ++k) {
-        for (std::size_t l = 0; l <= k; ++l) {
-            std::size_t kl = idx2(k, l);
-            if (ij > kl) continue;
-
-            ret(idx2(ij, kl)) = int_repulsion(bsList[i], bsList[j],
-                                              bsList[k], bsList[l]);
+    run_quartets(*this, opt, opt.schwarzThresh, EriSink{&ret(0)}, stat);
+    return ret;
+}
+
+EriTensor BasisSet::eri_tensor(const EriOption &opt, EriStat *stat) const {
+    EriTensor ret(n_func());
+    run_quartets(*this, opt, opt.schwarzThresh, EriSink{ret.data()}, stat);
+    return ret;
+}
+
+// collects the quartets of one thread into buffers for the writer
+struct FileSink {
+    static const std::size_t BUFFER_SIZE = std::size_t(1) << 16;   // doubles
+
+    EriFileWriter             *writer;
+    std::vector<EriBlockInfo>  info;
+    std::vector<double>        val;
+
+    bool skip(const SchwarzPair &, const SchwarzPair &) const { return false; }
+
+    void operator()(const Shell &a, const Shell &b, const Shell &c, const Shell &d,
+                    const double *v) {
+        EriBlockInfo bk = {0, {std::uint32_t(a.func), std::uint32_t(b.func),
+                               std::uint32_t(c.func), std::uint32_t(d.func)},
+                              {std::uint32_t(a.nfunc()), std::uint32_t(b.nfunc()),
+                               std::uint32_t(c.nfunc()), std::uint32_t(d.nfunc())}};
+        info.push_back(bk);
+        val.insert(val.end(), v, v + bk.size());
+        if (val.size() >= BUFFER_SIZE) writer->submit(info, val);
+    }
+};
+
+void BasisSet::write_eri_file(const std::string &fileName, const EriOption &opt,
+                              EriStat *stat) const {
+    EriFileWriter writer(fileName, n_func());
+    std::vector<RowWorker<FileSink>> worker =
+        run_quartets(*this, opt, opt.schwarzThresh, FileSink{&writer, {}, {}}, stat);
+    for (RowWorker<FileSink> &w : worker) {
+        if (!w.sink.info.empty()) writer.submit(w.sink.info, w.sink.val);
+    }
+    writer.close();
+}
+
+// compresses the quartets of one thread
+struct StoreSink {
+    EriStore store;
+
+    bool skip(const SchwarzPair &, const SchwarzPair &) const { return false; }
+
+    void operator()(const Shell &a, const Shell &b, const Shell &c, const Shell &d,
+                    const double *v) {
+        std::size_t func[] = {a.func, b.func, c.func, d.func};
+        std::size_t nfunc[] = {a.nfunc(), b.nfunc(), c.nfunc(), d.nfunc()};
+        store.add(func, nfunc, v);
+    }
+};
+
+EriStore BasisSet::eri_store(double absErr, const EriOption &opt, EriStat *stat) const {
+    EriStore ret(n_func(), absErr);
+    std::vector<RowWorker<StoreSink>> worker =
+        run_quartets(*this, opt, opt.schwarzThresh, StoreSink{ret}, stat);
+    for (const RowWorker<StoreSink> &w : worker) {
+        ret.append(w.sink.store);
+    }
+    return ret;
+}
+
+// contracts the quartets with the density into the J and K of one thread
+struct JKSink {
+    JKBuilder            jk;
+    const Matrix        *maxD;          // max |D| of the shell blocks
+    double               densityThresh; // 0 keeps every quartet
+
+    // Haser-Ahlrichs: the quartet changes J by at most Q_ab Q_cd times
+    // max |D| of the blocks cd and ab, and K by the same with the blocks
+    // ac, ad, bc and bd
+    bool skip(const SchwarzPair &bra, const SchwarzPair &ket) const {
+        if (densityThresh <= 0.0) return false;
+        std::size_t a = bra.i, b = bra.j, c = ket.i, d = ket.j;
+        double dmax = std::max({(*maxD)(a,b), (*maxD)(c,d), (*maxD)(a,c),
+                                (*maxD)(a,d), (*maxD)(b,c), (*maxD)(b,d)});
+        return bra.bound * ket.bound * dmax < densityThresh;
+    }
+
+    void operator()(const Shell &a, const Shell &b, const Shell &c, const Shell &d,
+                    const double *v) {
+        std::size_t func[] = {a.func, b.func, c.func, d.func};
+        std::size_t nfunc[] = {a.nfunc(), b.nfunc(), c.nfunc(), d.nfunc()};
+        jk.add(func, nfunc, v);
+    }
+};
+
+void BasisSet::mat_jk(const Matrix &D, Matrix &J, Matrix &K,
+                      const EriOption &opt, EriStat *stat) const {
+    std::size_t n = n_func();
+    assert(D.rows() == n && D.cols() == n);
+
+    // max |D| of every shell block, built again for every density
+    std::size_t nSh = shList.size();
+    Matrix maxD(nSh, nSh, 0.0);
+    double maxAll = 0.0;
+    for (std::size_t x = 0; x < nSh; ++x) {
+    for (std::size_t y = 0; y <= x; ++y) {
+        const Shell &a = shList[x], &b = shList[y];
+        double m = 0.0;
+        for (std::size_t i = a.func; i < a.func + a.nfunc(); ++i) {
+        for (std::size_t j = b.func; j < b.func + b.nfunc(); ++j) {
+            m = std::max(m, std::abs(D(i,j)));
         }}
+        maxD(x,y) = maxD(y,x) = m;
+        maxAll = std::max(maxAll, m);
+    }}
+
+    // |(ab|cd) D_xy| <= Q_ab Q_cd max|D|, so with densityThresh the
+    // threshold on Q_ab Q_cd rises as the density gets smaller and the
+    // rows stop early, the blocks of maxD screen the rest one by one
+    double thresh = opt.schwarzThresh;
+    if (opt.densityThresh > 0.0) {
+        thresh = maxAll > 0.0 ? std::max(thresh, opt.densityThresh / maxAll)
+                              : std::numeric_limits<double>::infinity();
+    }
+
+    JKSink proto = {JKBuilder(D), &maxD, opt.densityThresh};
+    std::vector<RowWorker<JKSink>> worker = run_quartets(*this, opt, thresh, proto, stat);
+
+    J = Matrix(n, n, 0.0);
+    K = Matrix(n, n, 0.0);
+    for (const RowWorker<JKSink> &w : worker) {
+        w.sink.jk.add_to(J, K);
+    }
+}
+
+// Q_ab of the pairs k, (ab|ab) costs about pair_cost(ab)^2
+struct SchwarzWorker {
+    const BasisSet             *bsSet;
+    const std::vector<PairIdx> *pairs;
+    EriEngine                   engine;
+    Matrix                     *ret;
+    EriClass                    eri;
+    std::vector<double>         val, tmp;
+
+    void operator()(std::size_t k);
+};
+
+void SchwarzWorker::operator()(std::size_t k) {
+    std::size_t i = (*pairs)[k].i, j = (*pairs)[k].j;
+    const Shell &a = bsSet->shList[i], &b = bsSet->shList[j];
+    const ShellPair &ab = bsSet->spList(i,j);
+    nhfInt::int_repulsion(engine, eri, a, b, a, b, ab, ab);
+
+    // the bound is over the functions, for pure shells those are the
+    // solid harmonics and not the Cartesian components
+    val.assign(eri.eriVal.begin(), eri.eriVal.end());
+    const Shell *sh[] = {&a, &b, &a, &b};
+    block_to_pure(val, sh, 4, tmp);
+
+    std::size_t na = a.nfunc(), nb = b.nfunc();
+    double maxVal = 0.0;
+    for (std::size_t ia = 0; ia < na; ++ia) {
+    for (std::size_t ib = 0; ib < nb; ++ib) {
+        maxVal = std::max(maxVal, std::abs(val[((ia * nb + ib) * na + ia) * nb + ib]));
     }}
+    (*ret)(i,j) = (*ret)(j,i) = std::sqrt(maxVal);
+}
+
+Matrix BasisSet::mat_schwarz(EriEngine engine) const {
+    std::size_t nSh = shList.size();
+    std::vector<PairIdx> pairs = shell_pairs(nSh);
+
+    std::vector<double> cost;
+    for (const PairIdx &ij : pairs) {
+        double c = pair_cost(shList[ij.i], shList[ij.j], spList(ij.i, ij.j));
+        cost.push_back(c * c);
+    }
+    TaskPlan plan(cost, num_threads());
+
+    Matrix ret(nSh, nSh, 0.0);
+    SchwarzWorker proto = {this, &pairs, engine, &ret, EriClass(), {}, {}};
+    std::vector<SchwarzWorker> worker(plan.n_thread(), proto);
+    run_tasks(plan, worker);
 
     return ret;
 }
 
+void BasisSet::int_repulsion_batch(const ShellQuartet *quartet, std::size_t n,
+                                   double *out, EriEngine engine,
+                                   const nhfBoys::BoysEvaluator &boys) const {
+    nhfInt::int_repulsion_batch(engine, shList, spList, quartet, n, out, boys);
+}
+
+void BasisSet::set_prim_thresh(double thresh) {
+    spList = ShellPairList(shList, thresh);
+}
+
+void BasisSet::set_pure(bool pure) {
+    std::size_t func = 0;
+    for (Shell &sh : shList) {
+        sh.pure = pure && sh.L >= 2;
+        sh.func = func;
+        func += sh.nfunc();
+    }
+}
+
 /* BasisSet constructors */
 BasisSet::BasisSet(
     const std::string &basisFileName,
@@ -176,24 +671,40 @@ BasisSet::BasisSet(
 
     BasisFile bsFile(basisFileName);
     for (std::size_t i = 0; i < atom.size(); ++i) {
-        AtomBasis atmBs = bsFile[atom[i]];
-        BasisSet bsSet(atmBs, geom[i]);
-        for (std::size_t j = 0; j < bsSet.size(); ++j) {
-            bsList.push_back(bsSet[j]);
-        }
+        add_basis(bsFile[atom[i]], geom[i]);
     }
+    spList = ShellPairList(shList, PRIM_THRESH);
 }
 
-BasisSet::BasisSet(const AtomBasis &atmBs, const Vec3d &v) {
+BasisSet::BasisSet(
+    const std::vector<AtomBasis> &atmBs,
+    const std::vector<Vec3d> &geom
+) {
+    assert(atmBs.size() == geom.size());
+
     for (std::size_t i = 0; i < atmBs.size(); ++i) {
-        BasisSet bsSet(atmBs[i], v);
-        for (std::size_t j = 0; j < bsSet.size(); ++j) {
-            bsList.push_back(bsSet[j]);
-        }
+        add_basis(atmBs[i], geom[i]);
     }
+    spList = ShellPairList(shList, PRIM_THRESH);
+}
+
+BasisSet::BasisSet(const AtomBasis &atmBs, const Vec3d &v) {
+    add_basis(atmBs, v);
+    spList = ShellPairList(shList, PRIM_THRESH);
 }
 
 BasisSet::BasisSet(const BasisInfo &bsInfo, const Vec3d &v) {
+    add_basis(bsInfo, v);
+    spList = ShellPairList(shList, PRIM_THRESH);
+}
+
+void BasisSet::add_basis(const AtomBasis &atmBs, const Vec3d &v) {
+    for (std::size_t i = 0; i < atmBs.size(); ++i) {
+        add_basis(atmBs[i], v);
+    }
+}
+
+void BasisSet::add_basis(const BasisInfo &bsInfo, const Vec3d &v) {
     std::size_t nGs = bsInfo.size();
 
     std::vector<double> alphaVec(nGs, 0.0);
@@ -215,9 +726,21 @@ BasisSet::BasisSet(const BasisInfo &bsInfo, const Vec3d &v) {
     if (bsInfo.basisType[0] == 'H') nAng = 5;
     if (bsInfo.basisType[0] == 'I') nAng = 6;
 
-    std::vector<AngMom> ijkSet = generate_angmom(nAng);
-    for (const AngMom &ijk : ijkSet) {
-        std::vector<double> coeffVec(comb1Vec);
+    add_shell(nAng, alphaVec, comb1Vec, v);
+
+    // SP type, add P orbital
+    if (bsInfo.basisType.size() > 1) {
+        add_shell(1, alphaVec, comb2Vec, v);
+    }
+}
+
+void BasisSet::add_shell(int L, const std::vector<double> &alphaVec,
+                         const std::vector<double> &combVec, const Vec3d &v) {
+    Shell sh(L, alphaVec, combVec, v, bsList.size());
+
+    std::size_t nGs = alphaVec.size();
+    for (const AngMom &ijk : sh.ijk) {
+        std::vector<double> coeffVec(combVec);
         for (std::size_t i = 0; i < nGs; ++i) {
             coeffVec[i] *= gto_norm_const(alphaVec[i], ijk.i, ijk.j, ijk.k);
         }
@@ -225,18 +748,7 @@ BasisSet::BasisSet(const BasisInfo &bsInfo, const Vec3d &v) {
         bsList.push_back(Basis(alphaVec, coeffVec, ijk, v));
     }
 
-    // SP type, add P orbital
-    if (bsInfo.basisType.size() > 1) {
-        std::vector<AngMom> ijkSet = generate_angmom(1);
-        for (const AngMom &ijk : ijkSet) {
-            std::vector<double> coeffVec(comb2Vec);
-            for (std::size_t i = 0; i < nGs; ++i) {
-                coeffVec[i] *= gto_norm_const(alphaVec[i], ijk.i, ijk.j, ijk.k);
-            }
-
-            bsList.push_back(Basis(alphaVec, coeffVec, ijk, v));
-        }
-    }
+    shList.push_back(sh);
 }
 
 
@@ -310,16 +822,307 @@ double int_repulsion(const Basis &a, const Basis &b,
     return ret;
 }
 
+
+/* molecular integrals over Shell */
+// 1D overlaps ov[dir][l1 * (Lb+1) + l2], l1 <= La, l2 <= Lb, of primitive
+// pair k, without the factor sqrt(pi/zeta)
+static void overlap_table(std::vector<double> (&ov)[3], int La, int Lb,
+                          const Vec3d &A, const Vec3d &B,
+                          const ShellPair &ab, std::size_t k) {
+    Vec3d P = ab.P(k);
+    for (int dir = 0; dir < 3; ++dir) {
+        ov[dir].resize((La + 1) * (Lb + 1));
+        for (int l1 = 0; l1 <= La; ++l1) {
+        for (int l2 = 0; l2 <= Lb; ++l2) {
+            ov[dir][l1 * (Lb + 1) + l2] =
+                overlap_1D(l1, l2, P[dir] - A[dir], P[dir] - B[dir], ab.zeta[k]);
+        }}
+    }
+}
+
+void int_overlap(std::vector<double> &out, const Shell &a, const Shell &b,
+                 const ShellPair &ab) {
+    out.assign(a.size() * b.size(), 0.0);
+
+    std::size_t nb = b.L + 1;
+    std::vector<double> ov[3];
+    for (std::size_t k = 0; k < ab.nprim(); ++k) {
+        overlap_table(ov, a.L, b.L, a.centre, b.centre, ab, k);
+        double pre = std::pow(nhfMath::PI * ab.invZeta[k], 1.5) * ab.K[k];
+
+        for (std::size_t ia = 0; ia < a.size(); ++ia) {
+        for (std::size_t ib = 0; ib < b.size(); ++ib) {
+            const AngMom &ma = a.ijk[ia], &mb = b.ijk[ib];
+            out[ia * b.size() + ib] += pre * ov[0][ma.i * nb + mb.i]
+                                           * ov[1][ma.j * nb + mb.j]
+                                           * ov[2][ma.k * nb + mb.k];
+        }}
+    }
+
+    for (std::size_t ia = 0; ia < a.size(); ++ia) {
+    for (std::size_t ib = 0; ib < b.size(); ++ib) {
+        out[ia * b.size() + ib] *= a.scale[ia] * b.scale[ib];
+    }}
+}
+
+void int_kinetic(std::vector<double> &out, const Shell &a, const Shell &b,
+                 const ShellPair &ab) {
+    out.assign(a.size() * b.size(), 0.0);
+
+    // T = beta (2 Lb + 3) S(a,b) - 2 beta^2 sum_i S(a,b+2i)
+    //   - 1/2 sum_i b_i (b_i - 1) S(a,b-2i)
+    std::size_t nb = b.L + 3;
+    std::vector<double> ov[3];
+    for (std::size_t k = 0; k < ab.nprim(); ++k) {
+        overlap_table(ov, a.L, b.L + 2, a.centre, b.centre, ab, k);
+        double pre = std::pow(nhfMath::PI * ab.invZeta[k], 1.5) * ab.K[k];
+        double beta = b.alpha[ab.pb[k]];
+
+        for (std::size_t ia = 0; ia < a.size(); ++ia) {
+        for (std::size_t ib = 0; ib < b.size(); ++ib) {
+            int la[3] = {a.ijk[ia].i, a.ijk[ia].j, a.ijk[ia].k};
+            int lb[3] = {b.ijk[ib].i, b.ijk[ib].j, b.ijk[ib].k};
+            double s[3], sp[3], sm[3];
+            for (int dir = 0; dir < 3; ++dir) {
+                const double *o = &ov[dir][la[dir] * nb];
+                s[dir] = o[lb[dir]];
+                sp[dir] = o[lb[dir] + 2];
+                sm[dir] = lb[dir] > 1 ? o[lb[dir] - 2] : 0.0;
+            }
+
+            double val = beta * (2.0 * b.L + 3.0) * s[0] * s[1] * s[2]
+                - 2.0 * beta * beta * (sp[0] * s[1] * s[2]
+                                     + s[0] * sp[1] * s[2]
+                                     + s[0] * s[1] * sp[2])
+                - 0.5 * (lb[0] * (lb[0] - 1.0) * sm[0] * s[1] * s[2]
+                       + lb[1] * (lb[1] - 1.0) * s[0] * sm[1] * s[2]
+                       + lb[2] * (lb[2] - 1.0) * s[0] * s[1] * sm[2]);
+            out[ia * b.size() + ib] += pre * val;
+        }}
+    }
+
+    for (std::size_t ia = 0; ia < a.size(); ++ia) {
+    for (std::size_t ib = 0; ib < b.size(); ++ib) {
+        out[ia * b.size() + ib] *= a.scale[ia] * b.scale[ib];
+    }}
+}
+
+void int_nuclear(std::vector<double> &out, const Shell &a, const Shell &b,
+                 const ShellPair &ab, const std::vector<int> &zval,
+                 const std::vector<Vec3d> &geom) {
+    assert(zval.size() == geom.size());
+    out.assign(a.size() * b.size(), 0.0);
+
+    // G[dir][(l1 * (Lb+1) + l2) * nI + I], I <= l1 + l2
+    const Vec3d &A = a.centre, &B = b.centre;
+    std::size_t nb = b.L + 1, nI = a.L + b.L + 1;
+    std::vector<double> G[3], fm(nI, 0.0);
+    for (int dir = 0; dir < 3; ++dir) {
+        G[dir].assign((a.L + 1) * nb * nI, 0.0);
+    }
+
+    for (std::size_t k = 0; k < ab.nprim(); ++k) {
+        Vec3d P = ab.P(k);
+        double zeta = ab.zeta[k];
+        double pre = -2.0 * nhfMath::PI * ab.invZeta[k] * ab.K[k];
+
+        for (std::size_t n = 0; n < geom.size(); ++n) {
+            const Vec3d &Z = geom[n];
+            for (int dir = 0; dir < 3; ++dir) {
+                for (int l1 = 0; l1 <= a.L; ++l1) {
+                for (int l2 = 0; l2 <= b.L; ++l2) {
+                    double *g = &G[dir][(l1 * nb + l2) * nI];
+                    for (int I = 0; I <= l1 + l2; ++I) {
+                        g[I] = G_I(I, l1, l2, P[dir] - A[dir], P[dir] - B[dir],
+                                   P[dir] - Z[dir], zeta);
+                    }
+                }}
+            }
+
+            double T = (P - Z).len2() * zeta;
+            nhfBoys::boysfun_all(int(nI) - 1, T, &fm[0]);
+
+            double preZ = pre * zval[n];
+            for (std::size_t ia = 0; ia < a.size(); ++ia) {
+            for (std::size_t ib = 0; ib < b.size(); ++ib) {
+                const AngMom &ma = a.ijk[ia], &mb = b.ijk[ib];
+                const double *gx = &G[0][(ma.i * nb + mb.i) * nI];
+                const double *gy = &G[1][(ma.j * nb + mb.j) * nI];
+                const double *gz = &G[2][(ma.k * nb + mb.k) * nI];
+
+                double sum = 0.0;
+                for (int i = 0; i <= ma.i + mb.i; ++i) {
+                for (int j = 0; j <= ma.j + mb.j; ++j) {
+                for (int l = 0; l <= ma.k + mb.k; ++l) {
+                    sum += gx[i] * gy[j] * gz[l] * fm[i+j+l];
+                }}}
+                out[ia * b.size() + ib] += preZ * sum;
+            }}
+        }
+    }
+
+    for (std::size_t ia = 0; ia < a.size(); ++ia) {
+    for (std::size_t ib = 0; ib < b.size(); ++ib) {
+        out[ia * b.size() + ib] *= a.scale[ia] * b.scale[ib];
+    }}
+}
+
+void int_repulsion(EriClass &eri,
+                   const Shell &a, const Shell &b,
+                   const Shell &c, const Shell &d,
+                   const ShellPair &ab, const ShellPair &cd,
+                   const nhfBoys::BoysEvaluator &boys) {
+    eri.reset(a.L, b.L, c.L, d.L);
+
+    const Vec3d &A = a.centre, &B = b.centre;
+    const Vec3d &C = c.centre, &D = d.centre;
+
+    // Carray of every (l1,l2,l3,l4) that occurs in one direction, shared
+    // by all components of the quartet. Each one gets a slot of nfm
+    // values in the scratch memory of the thread, fm comes last.
+    std::size_t nb = b.L + 1, nc = c.L + 1, nd = d.L + 1;
+    std::size_t n1D = (a.L + 1) * nb * nc * nd;
+    std::size_t nfm = a.L + b.L + c.L + d.L + 1;
+    double *bx = thread_scratch().get((3 * n1D + 1) * nfm);
+    double *by = bx + n1D * nfm, *bz = by + n1D * nfm;
+    double *fm = bz + n1D * nfm;
+
+    auto idx1D = [nb, nc, nd, nfm](int l1, int l2, int l3, int l4) -> std::size_t
+    { return (((l1 * nb + l2) * nc + l3) * nd + l4) * nfm; };
+
+    for (std::size_t kab = 0; kab < ab.nprim(); ++kab) {
+        double zeta12 = ab.zeta[kab];
+        double invZeta12 = ab.invZeta[kab];
+        Vec3d P = ab.P(kab);
+
+        for (std::size_t kcd = 0; kcd < cd.nprim(); ++kcd) {
+            double zeta34 = cd.zeta[kcd];
+            double invZeta34 = cd.invZeta[kcd];
+            Vec3d Q = cd.P(kcd);
+
+            double delta = 0.25 * (invZeta12 + invZeta34);
+            double xVal = 0.25 * (P - Q).len2() / delta;
+
+            for (int l1 = 0; l1 <= a.L; ++l1) {
+            for (int l2 = 0; l2 <= b.L; ++l2) {
+            for (int l3 = 0; l3 <= c.L; ++l3) {
+            for (int l4 = 0; l4 <= d.L; ++l4) {
+                std::size_t idx = idx1D(l1, l2, l3, l4);
+                Carray(bx + idx, l1, l2, l3, l4, P.x, A.x, B.x, Q.x, C.x, D.x,
+                       zeta12, zeta34, delta);
+                Carray(by + idx, l1, l2, l3, l4, P.y, A.y, B.y, Q.y, C.y, D.y,
+                       zeta12, zeta34, delta);
+                Carray(bz + idx, l1, l2, l3, l4, P.z, A.z, B.z, Q.z, C.z, D.z,
+                       zeta12, zeta34, delta);
+            }}}}
+
+            boys.all(int(nfm) - 1, xVal, fm);
+
+            double pre = 2.0 * std::pow(nhfMath::PI, 2.5)
+                       / (zeta12 * zeta34 * std::sqrt(zeta12 + zeta34))
+                       * ab.K[kab] * cd.K[kcd];
+
+            for (std::size_t ia = 0; ia < a.size(); ++ia) {
+            for (std::size_t ib = 0; ib < b.size(); ++ib) {
+            for (std::size_t ic = 0; ic < c.size(); ++ic) {
+            for (std::size_t id = 0; id < d.size(); ++id) {
+                const AngMom &ma = a.ijk[ia], &mb = b.ijk[ib];
+                const AngMom &mc = c.ijk[ic], &md = d.ijk[id];
+                const double *cx = bx + idx1D(ma.i, mb.i, mc.i, md.i);
+                const double *cy = by + idx1D(ma.j, mb.j, mc.j, md.j);
+                const double *cz = bz + idx1D(ma.k, mb.k, mc.k, md.k);
+
+                double sum = 0.0;
+                for (int i = 0; i <= ma.i + mb.i + mc.i + md.i; ++i) {
+                for (int j = 0; j <= ma.j + mb.j + mc.j + md.j; ++j) {
+                for (int k = 0; k <= ma.k + mb.k + mc.k + md.k; ++k) {
+                    sum += cx[i] * cy[j] * cz[k] * fm[i+j+k];
+                }}}
+
+                eri(ia, ib, ic, id) += pre * sum;
+            }}}}
+        }
+    }
+
+    for (std::size_t ia = 0; ia < a.size(); ++ia) {
+    for (std::size_t ib = 0; ib < b.size(); ++ib) {
+    for (std::size_t ic = 0; ic < c.size(); ++ic) {
+    for (std::size_t id = 0; id < d.size(); ++id) {
+        eri(ia, ib, ic, id) *= a.scale[ia] * b.scale[ib]
+                             * c.scale[ic] * d.scale[id];
+    }}}}
+}
+
+void int_repulsion(EriClass &eri,
+                   const Shell &a, const Shell &b,
+                   const Shell &c, const Shell &d) {
+    int_repulsion(eri, a, b, c, d, ShellPair(a, b), ShellPair(c, d));
+}
+
 }   // namespace (nhfTho)
 
 
-/* idx2 and idx4 */
-std::size_t idx2(std::size_t i, std::size_t j)
-{ return  i>j ? i * (i+1) / 2 + j : j * (j+1) / 2 + i; }
+void int_repulsion(EriEngine engine, EriClass &eri,
+                   const tho::Shell &a, const tho::Shell &b,
+                   const tho::Shell &c, const tho::Shell &d,
+                   const tho::ShellPair &ab, const tho::ShellPair &cd,
+                   const nhfBoys::BoysEvaluator &boys) {
+    switch (engine) {
+        case EriEngine::Tho: tho::int_repulsion(eri, a, b, c, d, ab, cd, boys); break;
+        case EriEngine::Hgp: hgp::int_repulsion(eri, a, b, c, d, ab, cd, boys); break;
+        case EriEngine::Rys: rys::int_repulsion(eri, a, b, c, d, ab, cd); break;
+        case EriEngine::Md:  md::int_repulsion(eri, a, b, c, d, ab, cd, boys);  break;
+        case EriEngine::Gen: gen::int_repulsion(eri, a, b, c, d, ab, cd, boys); break;
+    }
+}
 
-std::size_t idx4(std::size_t i, std::size_t j, 
-                 std::size_t k, std::size_t l)
-{ return  idx2(idx2(i,j), idx2(k,l)); }
+void int_repulsion(EriEngine engine, EriClass &eri,
+                   const tho::Shell &a, const tho::Shell &b,
+                   const tho::Shell &c, const tho::Shell &d) {
+    int_repulsion(engine, eri, a, b, c, d,
+                  tho::ShellPair(a, b), tho::ShellPair(c, d));
+}
+
+void int_repulsion_batch(EriEngine engine,
+                         const std::vector<tho::Shell> &shList,
+                         const tho::ShellPairList &spList,
+                         const ShellQuartet *quartet, std::size_t n,
+                         double *out, const nhfBoys::BoysEvaluator &boys) {
+    if (engine == EriEngine::Gen) {
+        gen::int_repulsion_batch(shList, spList, quartet, n, out, boys);
+        return;
+    }
+
+    EriClass eri;
+    std::size_t pos = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        const ShellQuartet &q = quartet[i];
+        int_repulsion(engine, eri, shList[q.a], shList[q.b], shList[q.c], shList[q.d],
+                      spList(q.a, q.b), spList(q.c, q.d), boys);
+        std::copy(eri.eriVal.begin(), eri.eriVal.end(), out + pos);
+        pos += eri.size();
+    }
+}
+
+
+/* threads */
+#ifdef NHFINT_OPENMP
+static int numThreads = 0;
+
+void set_num_threads(int n) {
+    numThreads = n > 0 ? n : 0;
+}
+
+int num_threads() {
+    return numThreads > 0 ? numThreads : omp_get_max_threads();
+}
+#else
+void set_num_threads(int) {}
+
+int num_threads() {
+    return 1;
+}
+#endif
 
 
 // normalization constants for Cartesian Gaussian function
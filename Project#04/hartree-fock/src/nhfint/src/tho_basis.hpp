@@ -3,10 +3,66 @@
 #include "vec3d.hpp"
 #include "matrix.hpp"
 #include "basisfile.hpp"
+#include "boysfun.hpp"
+#include "eri_class.hpp"
+#include "eri_tensor.hpp"
+#include "eri_store.hpp"
 #include <vector>
 #include <cstddef>
 
 namespace nhfInt {
+
+// engines that compute one EriClass of a shell quartet
+enum class EriEngine {
+    Tho,    // Taketa-Huzinaga-Ohata expansion
+    Hgp,    // Head-Gordon-Pople, VRR + HRR
+    Rys,    // Dupuis-King-Rys quadrature
+    Md,     // McMurchie-Davidson, Hermite expansion
+    Gen,    // kernels written by nhfint_gen, Hgp for the other classes
+};
+
+// options of BasisSet::mat_int_repulsion
+class EriOption {
+public:
+    EriEngine   engine;
+    double      schwarzThresh;  // skip (ab|cd) when Q_ab * Q_cd < schwarzThresh
+    double      boysTol;        // relative error of the Boys function, > 0 uses
+                                // nhfBoys::BoysChebyshev(boysTol), 0 the table
+    double      densityThresh;  // mat_jk only, > 0 also skips (ab|cd) when
+                                // Q_ab * Q_cd * max|D| < densityThresh, max
+                                // over the shell blocks ab, cd, ac, ad, bc, bd
+
+    EriOption(EriEngine engine = EriEngine::Hgp, double schwarzThresh = 1e-12,
+              double boysTol = 0.0, double densityThresh = 0.0)
+    : engine(engine), schwarzThresh(schwarzThresh), boysTol(boysTol),
+      densityThresh(densityThresh) {}
+};
+
+// what BasisSet::mat_int_repulsion did
+class EriStat {
+public:
+    std::size_t nQuartet;       // unique shell quartets
+    std::size_t nScreened;      // quartets skipped by the Schwarz or density screening
+    std::size_t nDensityScreened;   // of which by the density screening of mat_jk
+    std::size_t nPrimQuartet;   // primitive quartets of the computed quartets
+    std::size_t nPrimScreened;  // of which skipped by primitive pair screening
+
+    EriStat(): nQuartet(0), nScreened(0), nDensityScreened(0),
+               nPrimQuartet(0), nPrimScreened(0) {}
+};
+
+// threads of the mat_int_* functions of BasisSet, n <= 0 goes back to the
+// OpenMP default (OMP_NUM_THREADS or every core). Always 1 when nhfint is
+// built without NHFINT_OPENMP. The results do not depend on it.
+void set_num_threads(int n);
+int  num_threads();
+
+// one shell quartet (ab|cd) of a batch, indices into BasisSet::shList
+// with a >= b and c >= d, as the pairs are stored in ShellPairList
+struct ShellQuartet {
+    std::size_t a, b, c, d;
+};
+
 namespace tho {
 
 using nhfMath::Vec3d;
@@ -65,20 +121,144 @@ public:
 };
 
 
+// A shell is the set of Basis that share the same centre, exponents and
+// contraction, and whose angular momentum sums to the same L. The Basis of
+// one shell are stored contiguously in BasisSet::bsList starting at offset.
+// The integrals are always computed over the Cartesian components, a pure
+// shell is transformed to 2L+1 real solid harmonics when its block goes
+// into the matrices of BasisSet, where its functions start at func.
+class Shell {
+public:
+    int                 L;
+    Vec3d               centre;
+    std::vector<double> alpha;      // gaussian exponents
+    std::vector<double> coeff;      // coeff = comb * norm of (L,0,0)
+    std::vector<AngMom> ijk;        // generate_angmom(L)
+    std::vector<double> scale;      // norm of ijk[c] / norm of (L,0,0)
+    std::size_t         offset;     // index of ijk[0] in BasisSet::bsList
+    bool                pure;       // real solid harmonics, see cart_to_pure
+    std::size_t         func;       // index of the first function in the matrices
+
+    Shell(): L(0), offset(0), pure(false), func(0) {}
+    Shell(
+        int L,
+        const std::vector<double> &alphaVec,
+        const std::vector<double> &combVec,
+        const Vec3d &centre,
+        std::size_t offset
+    );
+
+    std::size_t size()  const { return ijk.size(); }     // Cartesian components
+    std::size_t nprim() const { return alpha.size(); }   // primitives
+    std::size_t nfunc() const { return pure ? 2 * L + 1 : size(); }
+};
+
+
+// Everything about the primitive pairs of two shells a, b that does not
+// depend on the other pair or on the Cartesian components. Pairs with
+// |K| < thresh are dropped, the rest are stored in the order of pa, pb.
+class ShellPair {
+public:
+    Vec3d               AB;         // A - B
+    std::vector<std::size_t> pa, pb;    // primitives of a and b
+    std::vector<double> zeta;       // alpha_a + alpha_b
+    std::vector<double> invZeta;    // 1 / zeta
+    std::vector<double> Px, Py, Pz; // gaussian product centre
+    std::vector<double> K;          // exp(-ab/zeta |AB|^2) * coeff_a * coeff_b
+    std::size_t         nScreened;  // primitive pairs dropped
+
+    ShellPair(): nScreened(0) {}
+    ShellPair(const Shell &a, const Shell &b, double thresh = 0.0);
+
+    std::size_t nprim() const { return zeta.size(); }
+    Vec3d       P(std::size_t k) const { return Vec3d(Px[k], Py[k], Pz[k]); }
+};
+
+
+// default primitive pair threshold of a BasisSet
+const double PRIM_THRESH = 1e-15;
+
+// shell pairs (ij) of a shell list, i >= j, stored at idx2(i,j)
+class ShellPairList {
+public:
+    std::vector<ShellPair> pairs;
+    double      primThresh;     // drop primitive pairs with |K| below it
+    std::size_t nPrimPair;      // primitive pairs of all shell pairs
+    std::size_t nPrimScreened;  // of which dropped
+
+    ShellPairList(): primThresh(0.0), nPrimPair(0), nPrimScreened(0) {}
+    ShellPairList(const std::vector<Shell> &shList, double primThresh);
+
+    const ShellPair& operator()(std::size_t i, std::size_t j) const;
+
+    std::size_t size() const { return pairs.size(); }
+};
+
+
 class BasisSet {
 public:
     std::vector<Basis> bsList;
+    std::vector<Shell> shList;
+    ShellPairList      spList;     // built once the shells are known,
+                                   // with PRIM_THRESH
 
     Basis  operator[](std::size_t i) const;
     Basis& operator[](std::size_t i);
 
     std::size_t size() const { return bsList.size(); }
 
+    // functions of the shells, the dimension of the matrices below.
+    // size() in the Cartesian mode, fewer when d and higher shells are pure
+    std::size_t n_func() const;
+
     Matrix mat_int_overlap() const;
     Matrix mat_int_kinetic() const;
     Matrix mat_int_nuclear(const std::vector<int> &zval, 
                             const std::vector<Vec3d> &geom) const;
-    Matrix mat_int_repulsion() const;
+    Matrix mat_int_repulsion(const EriOption &opt = EriOption(),
+                             EriStat *stat = nullptr) const;
+
+    // the integrals of mat_int_repulsion, as an EriTensor
+    EriTensor eri_tensor(const EriOption &opt = EriOption(),
+                         EriStat *stat = nullptr) const;
+
+    // the integrals of mat_int_repulsion into an ERI file, see EriFile.
+    // The blocks go to disk from a writer thread while the others are
+    // still computing.
+    void write_eri_file(const std::string &fileName, const EriOption &opt = EriOption(),
+                        EriStat *stat = nullptr) const;
+
+    // the integrals of mat_int_repulsion compressed with an absolute
+    // error of at most absErr, see EriStore
+    EriStore eri_store(double absErr, const EriOption &opt = EriOption(),
+                       EriStat *stat = nullptr) const;
+
+    // Coulomb and exchange matrices of a symmetric density D, integral
+    // direct: J_ab = sum_cd (ab|cd) D_cd and K_ab = sum_cd (ac|bd) D_cd.
+    // The quartets that pass the Schwarz screening of opt are computed
+    // once each, as in mat_int_repulsion, and contracted with their 8
+    // permutations on the fly, so nothing of size N^4 is stored. With
+    // opt.densityThresh the screening also weighs in the shell blocks of
+    // D that the quartet is contracted with.
+    void mat_jk(const Matrix &D, Matrix &J, Matrix &K,
+                const EriOption &opt = EriOption(), EriStat *stat = nullptr) const;
+
+    // Schwarz bound of shell pairs, Q_ab = sqrt(max |(ab|ab)|)
+    Matrix mat_schwarz(EriEngine engine = EriEngine::Hgp) const;
+
+    // (ab|cd) of n quartets of one class (La Lb|Lc Ld), quartet q is
+    // written to out + q * nCart in the layout of EriClass::eriVal, where
+    // nCart is the product of the four shell sizes
+    void int_repulsion_batch(const ShellQuartet *quartet, std::size_t n,
+                             double *out, EriEngine engine = EriEngine::Hgp,
+                             const nhfBoys::BoysEvaluator &boys = nhfBoys::boys_taylor()) const;
+
+    // rebuild spList, dropping primitive pairs with |K| < thresh
+    void set_prim_thresh(double thresh);
+
+    // pure: shells with L >= 2 give 2L+1 real solid harmonics instead of
+    // their Cartesian components, s and p shells are the same either way
+    void set_pure(bool pure);
 
     BasisSet(
         const std::string &basisFileName,
@@ -86,8 +266,19 @@ public:
         const std::vector<Vec3d> &geom
     );
 
+    BasisSet(
+        const std::vector<AtomBasis> &atmBs,
+        const std::vector<Vec3d> &geom
+    );
+
     BasisSet(const AtomBasis &atmBs, const Vec3d &v);
     BasisSet(const BasisInfo &bsInfo, const Vec3d &v);
+
+private:
+    void add_basis(const AtomBasis &atmBs, const Vec3d &v);
+    void add_basis(const BasisInfo &bsInfo, const Vec3d &v);
+    void add_shell(int L, const std::vector<double> &alphaVec,
+                   const std::vector<double> &combVec, const Vec3d &v);
 };
 
 
@@ -107,16 +298,53 @@ double int_nuclear(const Basis &a, const Basis &b,
 double int_repulsion(const Basis &a, const Basis &b,
                      const Basis &c, const Basis &d);
 
+/* molecular integrals over Shell */
+// all Cartesian components of a shell pair, out[ia * b.size() + ib]
+void int_overlap(std::vector<double> &out, const Shell &a, const Shell &b,
+                 const ShellPair &ab);
+void int_kinetic(std::vector<double> &out, const Shell &a, const Shell &b,
+                 const ShellPair &ab);
+void int_nuclear(std::vector<double> &out, const Shell &a, const Shell &b,
+                 const ShellPair &ab, const std::vector<int> &zval,
+                 const std::vector<Vec3d> &geom);
+
+// all Cartesian components of (ab|cd) in one call, the primitive quartet
+// setup is shared between the components.
+void int_repulsion(EriClass &eri,
+                   const Shell &a, const Shell &b,
+                   const Shell &c, const Shell &d,
+                   const ShellPair &ab, const ShellPair &cd,
+                   const nhfBoys::BoysEvaluator &boys = nhfBoys::boys_taylor());
+void int_repulsion(EriClass &eri,
+                   const Shell &a, const Shell &b,
+                   const Shell &c, const Shell &d);
+
 }   // namespace (tho)
 
 
-// When we use a one-dimensional array to store a symmetric matrix, 
-// idx2 calculates the position of the matrix element in the array.
-std::size_t idx2(std::size_t i, std::size_t j);
-std::size_t idx4(std::size_t i, std::size_t j, 
-                 std::size_t k, std::size_t l);
+// (ab|cd) of a shell quartet with the chosen engine, boys is the Boys
+// function of every engine but Rys, which has its own roots and weights
+void int_repulsion(EriEngine engine, EriClass &eri,
+                   const tho::Shell &a, const tho::Shell &b,
+                   const tho::Shell &c, const tho::Shell &d,
+                   const tho::ShellPair &ab, const tho::ShellPair &cd,
+                   const nhfBoys::BoysEvaluator &boys = nhfBoys::boys_taylor());
+void int_repulsion(EriEngine engine, EriClass &eri,
+                   const tho::Shell &a, const tho::Shell &b,
+                   const tho::Shell &c, const tho::Shell &d);
+
+// (ab|cd) of n quartets of one class with the chosen engine, laid out as
+// in BasisSet::int_repulsion_batch. The class is looked up once and the
+// engines that can work on a whole batch get it in one call.
+void int_repulsion_batch(EriEngine engine,
+                         const std::vector<tho::Shell> &shList,
+                         const tho::ShellPairList &spList,
+                         const ShellQuartet *quartet, std::size_t n,
+                         double *out,
+                         const nhfBoys::BoysEvaluator &boys = nhfBoys::boys_taylor());
+
 
 // normalization constants for Cartesian Gaussian function
 double gto_norm_const(double alpha, int l, int m, int n);
 
-}   // namespace (nhfInt)
\ No newline at end of file
+}   // namespace (nhfInt)
\ No newline at end of file
@@ -1,9 +1,11 @@
 #include "tho_int.hpp"
+#include "boysfun.hpp"
 #include "mathfun.hpp"
 #include "constant.hpp"
 #include <cmath>
 #include <algorithm>
 #include <vector>
+#include <atomic>
 #include <cstddef>
 
 
@@ -29,7 +31,18 @@ double binomial_prefactor(int j, int l, int m, double a, double b) {
 }
 
 double boysfun(int n, double x) {
-    if (x < 1e-5) return 1.0 / (2.0 * n + 1);
+    // the upward recursion below loses all precision when x is small
+    // compared with n, use the series expansion instead
+    // F_n(x) = exp(-x) * sum_k (2x)^k / ((2n+1)(2n+3)...(2n+2k+1))
+    if (x < 30.0) {
+        double term = 1.0 / (2.0 * n + 1);
+        double sum = term;
+        for (int k = 1; term > 1e-17 * sum; ++k) {
+            term *= 2.0 * x / (2.0 * n + 2.0 * k + 1);
+            sum += term;
+        }
+        return std::exp(-x) * sum;
+    }
     if (n == 0) return 0.5 * std::sqrt(nhfMath::PI/x) * std::erf(std::sqrt(x));
     return 0.5 / x * ( (2*n -1) * boysfun(n-1, x) - std::exp(-x) );
 }
@@ -37,18 +50,12 @@ double boysfun(int n, double x) {
 
 // ==================== gauss overlap =====================
 
-double gauss_int_overlap_1D(double alpha1, int l1, int x1,
-                            double alpha2, int l2, int x2) {
+double overlap_1D(int l1, int l2, double PA, double PB, double zeta) {
     double ret = 0.0;
-
-    double Px = (x1 * alpha1 + x2 * alpha2) / (alpha1 + alpha2);
-    double PAx = Px - x1;
-    double PBx = Px - x2;
-
     for (int i = 0; i <= (l1+l2)/2; ++i) {
-        ret +=   binomial_prefactor(2 * i, l1, l2, PAx, PBx)
+        ret +=   binomial_prefactor(2 * i, l1, l2, PA, PB)
                * nhfMath::semifactorial(2 * i - 1)
-               / std::pow(2.0 * (alpha1 + alpha2), i);
+               / std::pow(2.0 * zeta, i);
     }
     return  ret;
 }
@@ -58,11 +65,15 @@ double gauss_int_overlap(double alpha1, int l1, int m1, int n1, double x1, doubl
     double AB2 = (x1-x2)*(x1-x2) + (y1-y2)*(y1-y2) + (z1-z2)*(z1-z2);
     double invZeta = 1.0 / (alpha1 + alpha2);
 
+    double Px = (alpha1 * x1 + alpha2 * x2) * invZeta;
+    double Py = (alpha1 * y1 + alpha2 * y2) * invZeta;
+    double Pz = (alpha1 * z1 + alpha2 * z2) * invZeta;
+
     return  std::pow(nhfMath::PI * invZeta, 1.5)
           * std::exp(- alpha1 * alpha2 * invZeta * AB2)
-          * gauss_int_overlap_1D(alpha1, l1, x1, alpha2, l2, x2)
-          * gauss_int_overlap_1D(alpha1, m1, y1, alpha2, m2, y2)
-          * gauss_int_overlap_1D(alpha1, n1, z1, alpha2, n2, z2);
+          * overlap_1D(l1, l2, Px - x1, Px - x2, alpha1 + alpha2)
+          * overlap_1D(m1, m2, Py - y1, Py - y2, alpha1 + alpha2)
+          * overlap_1D(n1, n2, Pz - z1, Pz - z2, alpha1 + alpha2);
 }
 
 
@@ -105,7 +116,7 @@ double G_I(int I, int l1, int l2, double PAx, double PBx, double PCx, double g)
                 ret += std::pow(-1, i + u) * binomial_prefactor(i, l1, l2, PAx, PBx)
                         * nhfMath::factorial(i) * std::pow(PCx, k)
                         / nhfMath::factorial(r) / nhfMath::factorial(u)
-                        / nhfMath::factorial(k) * std::pow(4.0*g, r + u);
+                        / nhfMath::factorial(k) / std::pow(4.0*g, r + u);
             }
         }
     }
@@ -126,6 +137,10 @@ double gauss_int_nuclear(double alpha1, int l1, int m1, int n1, double x1, doubl
     double AB2 = (x1-x2)*(x1-x2) + (y1-y2)*(y1-y2) + (z1-z2)*(z1-z2);
     double CP2 = (Px-Zx)*(Px-Zx) + (Py-Zy)*(Py-Zy) + (Pz-Zz)*(Pz-Zz);
 
+    int mmax = l1 + l2 + m1 + m2 + n1 + n2;
+    double *fm = thread_scratch().get(std::size_t(mmax + 1));
+    nhfBoys::boysfun_all(mmax, CP2*zeta, fm);
+
     double ret = 0.0;
 
     for (int i = 0; i <= l1+l2; ++i) {
@@ -134,7 +149,7 @@ double gauss_int_nuclear(double alpha1, int l1, int m1, int n1, double x1, doubl
         ret += G_I(i, l1, l2, Px-x1, Px-x2, Px-Zx, zeta) *
                G_I(j, m1, m2, Py-y1, Py-y2, Py-Zy, zeta) *
                G_I(k, n1, n2, Pz-z1, Pz-z2, Pz-Zz, zeta) *
-               boysfun(i+j+k, CP2*zeta);
+               fm[i+j+k];
     }}}
 
     return - 2.0 * nhfMath::PI * invZeta 
@@ -166,25 +181,32 @@ double H_L(int L, int l1, int l2, double a, double b, double g)
     return ret;
 }
 
-std::vector<double>
-Carray(int l1, int l2, int l3, int l4,
-       double p, double a, double b,
-       double q, double c, double d,
-       double g1, double g2, double delta)
+void Carray(double *out, int l1, int l2, int l3, int l4,
+            double p, double a, double b,
+            double q, double c, double d,
+            double g1, double g2, double delta)
 {
-    std::size_t upper = std::size_t(l1 + l2 + l3 + l4 + 1);
-    std::vector<double> ret(upper, 0.0);
+    std::fill(out, out + l1 + l2 + l3 + l4 + 1, 0.0);
 
     for (int L = 0; L <= l1+l2; ++L) {
     for (int M = 0; M <= l3+l4; ++M) {
         for (int u = 0; u <= (L+M)/2; ++u) {
             int I = L + M - u;
-            ret[I] += H_L(L, l1, l2, p-a, p-b, g1) * H_L(M, l3, l4, q-c, q-d, g2)
+            out[I] += H_L(L, l1, l2, p-a, p-b, g1) * H_L(M, l3, l4, q-c, q-d, g2)
                         * std::pow(-1, M+u) * nhfMath::factorial(L+M) * std::pow(q-p, L+M-2*u)
                         / nhfMath::factorial(u) / nhfMath::factorial(L+M-2*u) / std::pow(delta, L+M-u);
         }
     }}
+}
 
+std::vector<double>
+Carray(int l1, int l2, int l3, int l4,
+       double p, double a, double b,
+       double q, double c, double d,
+       double g1, double g2, double delta)
+{
+    std::vector<double> ret(std::size_t(l1 + l2 + l3 + l4 + 1), 0.0);
+    Carray(ret.data(), l1, l2, l3, l4, p, a, b, q, c, d, g1, g2, delta);
     return ret;
 }
 
@@ -211,17 +233,23 @@ double gauss_int_repulsion(double alpha1, int l1, int m1, int n1, double x1, dou
 
     double delta = 0.25 * (invZeta12 + invZeta34);
 
-    auto bx = Carray(l1, l2, l3, l4, Px, x1, x2, Qx, x3, x4, zeta12, zeta34, delta);
-    auto by = Carray(m1, m2, m3, m4, Py, y1, y2, Qy, y3, y4, zeta12, zeta34, delta);
-    auto bz = Carray(n1, n2, n3, n4, Pz, z1, z2, Qz, z3, z4, zeta12, zeta34, delta);
+    int nx = l1 + l2 + l3 + l4 + 1, ny = m1 + m2 + m3 + m4 + 1;
+    int nz = n1 + n2 + n3 + n4 + 1;
+    int mmax = nx + ny + nz - 3;
+    double *bx = thread_scratch().get(std::size_t(nx + ny + nz + mmax + 1));
+    double *by = bx + nx, *bz = by + ny, *fm = bz + nz;
+    Carray(bx, l1, l2, l3, l4, Px, x1, x2, Qx, x3, x4, zeta12, zeta34, delta);
+    Carray(by, m1, m2, m3, m4, Py, y1, y2, Qy, y3, y4, zeta12, zeta34, delta);
+    Carray(bz, n1, n2, n3, n4, Pz, z1, z2, Qz, z3, z4, zeta12, zeta34, delta);
 
     double xVal = 0.25*PQ2/delta;
+    nhfBoys::boysfun_all(mmax, xVal, fm);
 
     double ret = 0.0;
-    for(int i = 0; i <= (l1+l2+l3+l4); ++i) {
-    for(int j = 0; j <= (m1+m2+m3+m4); ++j) {
-    for(int k = 0; k <= (n1+n2+n3+n4); ++k) {
-        ret += bx[i] * by[j] * bz[k] * boysfun(i+j+k, xVal);
+    for(int i = 0; i < nx; ++i) {
+    for(int j = 0; j < ny; ++j) {
+    for(int k = 0; k < nz; ++k) {
+        ret += bx[i] * by[j] * bz[k] * fm[i+j+k];
     }}}
 
     return  2.0 * std::pow(nhfMath::PI, 2.5)
@@ -232,5 +260,28 @@ double gauss_int_repulsion(double alpha1, int l1, int m1, int n1, double x1, dou
 }
 
 
+// ==================== scratch memory =====================
+
+namespace {
+std::atomic<std::size_t> scratchAllocCount(0);
+}
+
+double* EriScratch::get(std::size_t n) {
+    if (n > buf.size()) {
+        buf.resize(std::max(n, 2 * buf.size()));
+        ++scratchAllocCount;
+    }
+    return buf.data();
+}
+
+EriScratch& thread_scratch() {
+    static thread_local EriScratch scratch;
+    return scratch;
+}
+
+std::size_t scratch_alloc_count() {
+    return scratchAllocCount;
+}
+
 }  // namespace (tho)
-}  // namespace (nhfInt)
\ No newline at end of file
+}  // namespace (nhfInt)
\ No newline at end of file
@@ -1,8 +1,56 @@
 #pragma once
 
+#include <vector>
+#include <cstddef>
+
 namespace nhfInt {
 namespace tho {
 
+// boys function F_n(x) from the series and the upward recursion, kept as a
+// reference, the kernels use the tabulated nhfBoys::boysfun
+double boysfun(int n, double x);
+
+// one dimensional overlap of x_A^l1 x_B^l2 exp(-zeta x_P^2), without
+// the factor sqrt(pi/zeta)
+double overlap_1D(int l1, int l2, double PA, double PB, double zeta);
+
+// one dimensional expansion coefficients of the nuclear attraction, the
+// product of the three directions is contracted with F_(I+J+K)(x)
+double G_I(int I, int l1, int l2, double PAx, double PBx, double PCx, double g);
+
+// one dimensional expansion coefficients of (ab|cd), the product of the
+// three directions is contracted with F_(i+j+k)(x) in gauss_int_repulsion.
+// out receives l1+l2+l3+l4+1 values.
+void Carray(double *out, int l1, int l2, int l3, int l4,
+            double p, double a, double b,
+            double q, double c, double d,
+            double g1, double g2, double delta);
+std::vector<double>
+Carray(int l1, int l2, int l3, int l4,
+       double p, double a, double b,
+       double q, double c, double d,
+       double g1, double g2, double delta);
+
+
+// Scratch memory of the THO kernels. get(n) returns n doubles that stay
+// valid until the next get. The buffer only grows, so a loop of ERI calls
+// allocates only until it has seen its largest class.
+class EriScratch {
+public:
+    double* get(std::size_t n);
+
+    std::size_t capacity() const { return buf.size(); }
+
+private:
+    std::vector<double> buf;
+};
+
+// the EriScratch of the calling thread
+EriScratch& thread_scratch();
+
+// times an EriScratch had to allocate, summed over all threads
+std::size_t scratch_alloc_count();
+
 double gauss_int_overlap(double alpha1, int l1, int m1, int n1, double x1, double y1, double z1,
                          double alpha2, int l2, int m2, int n2, double x2, double y2, double z2);
 
@@ -19,4 +67,4 @@ double gauss_int_repulsion(double alpha1, int l1, int m1, int n1, double x1, dou
                            double alpha4, int l4, int m4, int n4, double x4, double y4, double z4);
 
 }  // namespace (tho)
-}  // namespace (nhfInt)
\ No newline at end of file
+}  // namespace (nhfInt)
\ No newline at end of file
@@ -0,0 +1,23 @@
+#include <atomic>
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+
+// Every operator new of the test binary is counted, to check that the
+// THO kernels do not allocate once their scratch memory has grown. The
+// replacements live in a translation unit of their own, so the compiler
+// never pairs an inlined free() with the builtin operator new of a caller.
+static std::atomic<std::size_t> newCount(0);
+
+std::size_t new_count() { return newCount; }
+
+void* operator new(std::size_t n) {
+    ++newCount;
+    if (void *p = std::malloc(n == 0 ? 1 : n)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t n) { return ::operator new(n); }
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
@@ -0,0 +1,880 @@
+#include "tho_basis.hpp"
+#include "tho_int.hpp"
+#include "rys_int.hpp"
+#include "hgp_int.hpp"
+#include "gen_int.hpp"
+#include "spherical.hpp"
+#include "scheduler.hpp"
+#include "fock.hpp"
+#include "eri_file.hpp"
+#include "basisfile.hpp"
+#include <gtest/gtest.h>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+
+static const double absErr = 1e-12;
+
+// the operator new calls of the test binary so far, see new_count.cpp
+std::size_t new_count();
+
+using nhfMath::Vec3d;
+using nhfMath::Matrix;
+using nhfInt::tho::BasisSet;
+using nhfInt::EriEngine;
+
+// a small two atom basis with S, SP, D and P shells
+static BasisSet test_basis_set() {
+    nhfInt::AtomBasis heavy({
+        "C     0",
+        "S    3   1.00",
+        "0.1722560000E+03       0.6176690000E-01",
+        "0.2591090000E+02       0.3587940000E+00",
+        "0.5533350000E+01       0.7007130000E+00",
+        "SP   2   1.00",
+        "0.3664980000E+01      -0.3958970000E+00       0.2364600000E+00",
+        "0.7705450000E+00       0.1215840000E+01       0.8606190000E+00",
+        "D    1   1.00",
+        "0.8000000000E+00       1.0000000"
+    });
+
+    nhfInt::AtomBasis light({
+        "H     0",
+        "S    2   1.00",
+        "0.5447178000E+01       0.1562850000E+00",
+        "0.8245470000E+00       0.9046910000E+00",
+        "P    1   1.00",
+        "0.1100000000E+01       1.0000000"
+    });
+
+    return BasisSet({heavy, light},
+                    {Vec3d(0.0, 0.1, -0.2), Vec3d(0.3, -1.1, 1.7)});
+}
+
+// high angular momentum basis, two atoms with D and F shells, the light
+// one at the default position or at h
+static BasisSet test_basis_set_df(const Vec3d &h = Vec3d(-0.4, 1.3, 0.9)) {
+    nhfInt::AtomBasis heavy({
+        "Fe     0",
+        "SP   2   1.00",
+        "0.1200000000E+01       0.6000000000E+00       0.4000000000E+00",
+        "0.3100000000E+00       0.5000000000E+00       0.7000000000E+00",
+        "D    2   1.00",
+        "0.2300000000E+01       0.4000000000E+00",
+        "0.5500000000E+00       0.7000000000E+00",
+        "F    1   1.00",
+        "0.9000000000E+00       1.0000000"
+    });
+
+    nhfInt::AtomBasis light({
+        "H     0",
+        "S    1   1.00",
+        "0.6000000000E+00       1.0000000",
+        "D    1   1.00",
+        "0.7000000000E+00       1.0000000"
+    });
+
+    return BasisSet({heavy, light}, {Vec3d(0.2, 0.0, 0.1), h});
+}
+
+// a symmetric density of n functions with elements of both signs
+static Matrix test_density(std::size_t n) {
+    Matrix D(n, n, 0.0);
+    for (std::size_t i = 0; i < n; ++i) {
+    for (std::size_t j = 0; j <= i; ++j) {
+        D(i,j) = D(j,i) = std::sin(1.3 * i + 0.7 * j + 0.1 * i * j) / (1.0 + i - j);
+    }}
+    return D;
+}
+
+// J and K from the stored integrals, every (ij|kl) of the full sums
+static void jk_from_eri(const Matrix &eri, const Matrix &D, Matrix &J, Matrix &K) {
+    std::size_t n = D.rows();
+    J = Matrix(n, n, 0.0);
+    K = Matrix(n, n, 0.0);
+    for (std::size_t i = 0; i < n; ++i) {
+    for (std::size_t j = 0; j < n; ++j) {
+    for (std::size_t k = 0; k < n; ++k) {
+    for (std::size_t l = 0; l < n; ++l) {
+        J(i,j) += eri(nhfInt::idx4(i, j, k, l)) * D(k,l);
+        K(i,k) += eri(nhfInt::idx4(i, j, k, l)) * D(j,l);
+    }}}}
+}
+
+static void expect_same_matrix(const Matrix &mat, const Matrix &ref, double err) {
+    ASSERT_EQ(mat.rows(), ref.rows());
+    ASSERT_EQ(mat.cols(), ref.cols());
+    for (std::size_t i = 0; i < ref.size(); ++i) {
+        EXPECT_NEAR(mat(i), ref(i), err);
+    }
+}
+
+static void expect_same_eri(const Matrix &eri, const Matrix &ref) {
+    ASSERT_EQ(eri.size(), ref.size());
+    for (std::size_t i = 0; i < ref.size(); ++i) {
+        EXPECT_NEAR(eri(i), ref(i), absErr);
+    }
+}
+
+
+TEST(TestBasisSet, TestShellLayout) {
+    BasisSet bsSet = test_basis_set();
+
+    ASSERT_EQ(bsSet.shList.size(), 6u);
+    EXPECT_EQ(bsSet.size(), 1u + 1u + 3u + 6u + 1u + 3u);
+
+    std::size_t offset = 0;
+    for (const nhfInt::tho::Shell &sh : bsSet.shList) {
+        EXPECT_EQ(sh.offset, offset);
+        for (std::size_t c = 0; c < sh.size(); ++c) {
+            const nhfInt::tho::Basis &bs = bsSet.bsList[sh.offset + c];
+            EXPECT_TRUE(bs[0].ijk == sh.ijk[c]);
+            for (std::size_t p = 0; p < sh.nprim(); ++p) {
+                EXPECT_NEAR(bs[p].coeff, sh.coeff[p] * sh.scale[c],
+                            1e-14 * std::abs(bs[p].coeff));
+            }
+        }
+        offset += sh.size();
+    }
+}
+
+
+TEST(TestBasisSet, TestShellPairOneElectron) {
+    BasisSet bsSet = test_basis_set_df();
+    std::vector<int> zval = {26, 1};
+    std::vector<Vec3d> geom = {Vec3d(0.2, 0.0, 0.1), Vec3d(-0.4, 1.3, 0.9)};
+
+    Matrix S = bsSet.mat_int_overlap();
+    Matrix T = bsSet.mat_int_kinetic();
+    Matrix V = bsSet.mat_int_nuclear(zval, geom);
+
+    // against the integrals over Basis
+    for (std::size_t i = 0; i < bsSet.size(); ++i) {
+    for (std::size_t j = 0; j < bsSet.size(); ++j) {
+        const nhfInt::tho::Basis &a = bsSet.bsList[i], &b = bsSet.bsList[j];
+        double Vref = 0.0;
+        for (std::size_t k = 0; k < geom.size(); ++k) {
+            Vref += nhfInt::tho::int_nuclear(a, b, geom[k]) * zval[k];
+        }
+        EXPECT_NEAR(S(i,j), nhfInt::tho::int_overlap(a, b), absErr);
+        EXPECT_NEAR(T(i,j), nhfInt::tho::int_kinetic(a, b), absErr);
+        EXPECT_NEAR(V(i,j), Vref, absErr * std::abs(Vref));
+    }}
+
+    // a far unit charge sees the overlap distribution as a point
+    const double R = 1e4;
+    Matrix Vfar = bsSet.mat_int_nuclear({1}, {Vec3d(0.0, 0.0, R)});
+    for (std::size_t i = 0; i < S.size(); ++i) {
+        EXPECT_NEAR(Vfar(i), -S(i) / R, 1e-7);
+    }
+}
+
+
+TEST(TestBasisSet, TestShellRepulsion) {
+    BasisSet bsSet = test_basis_set();
+    Matrix eri = bsSet.mat_int_repulsion();
+
+    std::size_t nBs = bsSet.size();
+    for (std::size_t i = 0; i < nBs; ++i) {
+    for (std::size_t j = 0; j <= i; ++j) {
+    for (std::size_t k = 0; k < nBs; ++k) {
+    for (std::size_t l = 0; l <= k; ++l) {
+        if (nhfInt::idx2(i, j) > nhfInt::idx2(k, l)) continue;
+        double ref = nhfInt::tho::int_repulsion(bsSet[i], bsSet[j],
+                                                bsSet[k], bsSet[l]);
+        EXPECT_NEAR(eri(nhfInt::idx4(i, j, k, l)), ref, absErr);
+    }}}}
+}
+
+
+TEST(TestBasisSet, TestHgpRepulsion) {
+    BasisSet bsSet = test_basis_set();
+    expect_same_eri(bsSet.mat_int_repulsion(EriEngine::Hgp),
+                    bsSet.mat_int_repulsion(EriEngine::Tho));
+
+    BasisSet bsSetDF = test_basis_set_df();
+    expect_same_eri(bsSetDF.mat_int_repulsion(EriEngine::Hgp),
+                    bsSetDF.mat_int_repulsion(EriEngine::Tho));
+}
+
+
+TEST(TestBasisSet, TestHgpFixedKernel) {
+    // every class of S, P and D shells goes through a specialized kernel
+    BasisSet bsSet = test_basis_set();
+    const std::vector<nhfInt::tho::Shell> &sh = bsSet.shList;
+
+    nhfInt::EriClass eri, ref;
+    for (std::size_t i = 0; i < sh.size(); ++i) {
+    for (std::size_t j = 0; j <= i; ++j) {
+    for (std::size_t k = 0; k < sh.size(); ++k) {
+    for (std::size_t l = 0; l <= k; ++l) {
+        const nhfInt::tho::ShellPair &ab = bsSet.spList(i,j), &cd = bsSet.spList(k,l);
+        nhfInt::hgp::int_repulsion(eri, sh[i], sh[j], sh[k], sh[l], ab, cd);
+        nhfInt::hgp::int_repulsion_generic(ref, sh[i], sh[j], sh[k], sh[l], ab, cd);
+        ASSERT_EQ(eri.size(), ref.size());
+        for (std::size_t n = 0; n < ref.size(); ++n) {
+            EXPECT_NEAR(eri.eriVal[n], ref.eriVal[n], 1e-14 * std::abs(ref.eriVal[n]));
+        }
+    }}}}
+}
+
+
+TEST(TestBasisSet, TestGenRepulsion) {
+#ifdef NHFINT_GENERATED_ERI
+    EXPECT_TRUE(nhfInt::gen::has_kernel(1, 0, 2, 1));
+#endif
+    BasisSet bsSet = test_basis_set();
+    Matrix eri = bsSet.mat_int_repulsion(EriEngine::Gen);
+    Matrix ref = bsSet.mat_int_repulsion(EriEngine::Hgp);
+    expect_same_eri(eri, ref);
+
+    // the SIMD lanes only change the order of the primitive sums
+    double refMax = 0.0;
+    for (std::size_t i = 0; i < ref.size(); ++i) {
+        refMax = std::max(refMax, std::abs(ref(i)));
+    }
+    for (std::size_t i = 0; i < ref.size(); ++i) {
+        EXPECT_NEAR(eri(i), ref(i), 1e-14 * refMax);
+    }
+
+    BasisSet bsSetDF = test_basis_set_df();
+    expect_same_eri(bsSetDF.mat_int_repulsion(EriEngine::Gen),
+                    bsSetDF.mat_int_repulsion(EriEngine::Tho));
+}
+
+
+TEST(TestBasisSet, TestBatchRepulsion) {
+    BasisSet bsSet = test_basis_set_df();
+    const std::vector<nhfInt::tho::Shell> &shList = bsSet.shList;
+
+    // every quartet of the classes (ds|ps), (ff|dd) and (pp|pp)
+    std::vector<std::vector<int>> classList = {
+        {2, 0, 1, 0}, {3, 3, 2, 2}, {1, 1, 1, 1}
+    };
+    for (const std::vector<int> &cls : classList) {
+        std::vector<nhfInt::ShellQuartet> quartet;
+        for (std::size_t a = 0; a < shList.size(); ++a) {
+        for (std::size_t b = 0; b <= a; ++b) {
+        for (std::size_t c = 0; c < shList.size(); ++c) {
+        for (std::size_t d = 0; d <= c; ++d) {
+            if (shList[a].L == cls[0] && shList[b].L == cls[1] &&
+                shList[c].L == cls[2] && shList[d].L == cls[3]) {
+                quartet.push_back({a, b, c, d});
+            }
+        }}}}
+        ASSERT_FALSE(quartet.empty());
+
+        for (EriEngine engine : {EriEngine::Gen, EriEngine::Hgp, EriEngine::Rys}) {
+            nhfInt::EriClass eri(cls[0], cls[1], cls[2], cls[3]);
+            std::size_t nCart = eri.size();
+            std::vector<double> out(quartet.size() * nCart, 0.0);
+            bsSet.int_repulsion_batch(quartet.data(), quartet.size(),
+                                      out.data(), engine);
+
+            for (std::size_t i = 0; i < quartet.size(); ++i) {
+                const nhfInt::ShellQuartet &q = quartet[i];
+                nhfInt::int_repulsion(engine, eri,
+                    shList[q.a], shList[q.b], shList[q.c], shList[q.d],
+                    bsSet.spList(q.a, q.b), bsSet.spList(q.c, q.d));
+                for (std::size_t k = 0; k < nCart; ++k) {
+                    EXPECT_NEAR(out[i * nCart + k], eri.eriVal[k], absErr);
+                }
+            }
+        }
+    }
+}
+
+
+TEST(TestBasisSet, TestThoNoAlloc) {
+    BasisSet bsSet = test_basis_set();
+    const std::vector<nhfInt::tho::Shell> &shList = bsSet.shList;
+    std::size_t nSh = shList.size();
+
+    nhfInt::EriClass eri;
+    auto all_quartets = [&]() {
+        for (std::size_t a = 0; a < nSh; ++a) {
+        for (std::size_t b = 0; b <= a; ++b) {
+        for (std::size_t c = 0; c < nSh; ++c) {
+        for (std::size_t d = 0; d <= c; ++d) {
+            nhfInt::tho::int_repulsion(eri, shList[a], shList[b], shList[c], shList[d],
+                                       bsSet.spList(a, b), bsSet.spList(c, d));
+        }}}}
+        nhfInt::tho::gauss_int_repulsion(
+            0.9, 2, 0, 1,  0.0,  0.1, -0.2,   1.3, 0, 1, 1,  0.4, -0.5,  0.3,
+            0.7, 1, 1, 0, -0.6,  0.2,  0.8,   1.1, 0, 0, 2,  0.3,  0.9, -0.4);
+    };
+
+    // the first pass grows eri and the scratch memory, the second one
+    // must not allocate at all
+    all_quartets();
+    std::size_t scratch0 = nhfInt::tho::scratch_alloc_count();
+    std::size_t new0 = new_count();
+    all_quartets();
+    std::size_t new1 = new_count();
+    EXPECT_EQ(new1, new0);
+    EXPECT_EQ(nhfInt::tho::scratch_alloc_count(), scratch0);
+    EXPECT_GT(scratch0, 0u);
+}
+
+
+TEST(TestBasisSet, TestRysRepulsion) {
+    BasisSet bsSet = test_basis_set();
+    expect_same_eri(bsSet.mat_int_repulsion(EriEngine::Rys),
+                    bsSet.mat_int_repulsion(EriEngine::Tho));
+
+    BasisSet bsSetDF = test_basis_set_df();
+    expect_same_eri(bsSetDF.mat_int_repulsion(EriEngine::Rys),
+                    bsSetDF.mat_int_repulsion(EriEngine::Hgp));
+}
+
+
+TEST(TestRys, TestGaussRepulsion) {
+    // primitive quartets up to g functions, compared with THO
+    std::vector<std::vector<int>> lmnList = {
+        {0,0,0, 0,0,0, 0,0,0, 0,0,0},
+        {1,0,0, 0,1,0, 0,0,1, 1,0,0},
+        {2,0,0, 0,1,1, 0,0,2, 1,1,0},
+        {1,2,0, 0,3,0, 0,1,2, 2,0,1},
+        {4,0,0, 0,2,2, 1,1,2, 0,0,4},
+        {2,1,1, 3,1,0, 0,4,0, 1,2,1},
+    };
+
+    for (const std::vector<int> &l : lmnList) {
+        double ref = nhfInt::tho::gauss_int_repulsion(
+            0.9, l[0], l[1],  l[2],  0.0,  0.1, -0.2,
+            1.3, l[3], l[4],  l[5],  0.4, -0.5,  0.3,
+            0.7, l[6], l[7],  l[8], -0.6,  0.2,  0.8,
+            1.1, l[9], l[10], l[11], 0.3,  0.9, -0.4);
+        double val = nhfInt::rys::gauss_int_repulsion(
+            0.9, l[0], l[1],  l[2],  0.0,  0.1, -0.2,
+            1.3, l[3], l[4],  l[5],  0.4, -0.5,  0.3,
+            0.7, l[6], l[7],  l[8], -0.6,  0.2,  0.8,
+            1.1, l[9], l[10], l[11], 0.3,  0.9, -0.4);
+        EXPECT_NEAR(val, ref, 1e-10 * std::max(1.0, std::abs(ref)));
+    }
+}
+
+
+TEST(TestRys, TestRoots) {
+    // sum_i w_i t_i^k reproduces F_k(x) for k < 2n
+    for (int n = 1; n <= nhfInt::rys::MAX_ROOTS; ++n) {
+        for (double x = 0.0; x < 200.0; x += 0.7) {
+            double root[nhfInt::rys::MAX_ROOTS], weight[nhfInt::rys::MAX_ROOTS];
+            nhfInt::rys::rys_roots(n, x, root, weight);
+            for (int k = 0; k < 2 * n; ++k) {
+                double sum = 0.0;
+                for (int i = 0; i < n; ++i) {
+                    sum += weight[i] * std::pow(root[i], k);
+                }
+                double ref = nhfInt::tho::boysfun(k, x);
+                EXPECT_NEAR(sum, ref, 1e-13 * ref);
+            }
+        }
+    }
+}
+
+
+TEST(TestBasisSet, TestMdRepulsion) {
+    BasisSet bsSet = test_basis_set();
+    expect_same_eri(bsSet.mat_int_repulsion(EriEngine::Md),
+                    bsSet.mat_int_repulsion(EriEngine::Tho));
+
+    BasisSet bsSetDF = test_basis_set_df();
+    expect_same_eri(bsSetDF.mat_int_repulsion(EriEngine::Md),
+                    bsSetDF.mat_int_repulsion(EriEngine::Hgp));
+}
+
+
+TEST(TestBasisSet, TestSchwarzScreening) {
+    // a chain of distant atoms, most quartets are negligible
+    nhfInt::AtomBasis atm({
+        "H     0",
+        "S    2   1.00",
+        "0.5447178000E+01       0.1562850000E+00",
+        "0.8245470000E+00       0.9046910000E+00",
+        "P    1   1.00",
+        "0.1100000000E+01       1.0000000"
+    });
+
+    std::vector<nhfInt::AtomBasis> atmList(6, atm);
+    std::vector<Vec3d> geom;
+    for (std::size_t i = 0; i < atmList.size(); ++i) {
+        geom.push_back(Vec3d(0.0, 0.0, 12.0 * i));
+    }
+    BasisSet bsSet(atmList, geom);
+
+    const double thresh = 1e-10;
+    nhfInt::EriStat stat, statFull;
+    Matrix eri = bsSet.mat_int_repulsion(nhfInt::EriOption(EriEngine::Hgp, thresh), &stat);
+    Matrix ref = bsSet.mat_int_repulsion(nhfInt::EriOption(EriEngine::Hgp, 0.0), &statFull);
+
+    std::size_t nPair = bsSet.shList.size() * (bsSet.shList.size() + 1) / 2;
+    EXPECT_EQ(stat.nQuartet, nPair * (nPair + 1) / 2);
+    EXPECT_EQ(statFull.nScreened, 0u);
+    EXPECT_GT(stat.nScreened, stat.nQuartet / 2);
+
+    for (std::size_t i = 0; i < ref.size(); ++i) {
+        EXPECT_NEAR(eri(i), ref(i), thresh);
+    }
+}
+
+
+TEST(TestBasisSet, TestPrimScreening) {
+    // tight core primitives on distant atoms
+    nhfInt::AtomBasis atm({
+        "C     0",
+        "S    6   1.00",
+        "0.3047524880E+04       0.1834737132E-02",
+        "0.4573695180E+03       0.1403732281E-01",
+        "0.1039486850E+03       0.6884262226E-01",
+        "0.2921015530E+02       0.2321844432E+00",
+        "0.9286662960E+01       0.4679413484E+00",
+        "0.3163926960E+01       0.3623119853E+00",
+        "SP   1   1.00",
+        "0.1687144782E+00       0.1000000000E+01       0.1000000000E+01"
+    });
+    BasisSet bsSet({atm, atm}, {Vec3d(0.0, 0.0, 0.0), Vec3d(0.0, 0.0, 2.9)});
+
+    nhfInt::EriStat ref;
+    Matrix eriRef = bsSet.mat_int_repulsion(nhfInt::EriOption(EriEngine::Hgp, 0.0), &ref);
+    Matrix SRef = bsSet.mat_int_overlap();
+
+    const double thresh = 1e-10;
+    bsSet.set_prim_thresh(thresh);
+    EXPECT_GT(bsSet.spList.nPrimScreened, 0u);
+    EXPECT_LT(bsSet.spList.nPrimScreened, bsSet.spList.nPrimPair);
+
+    nhfInt::EriStat stat;
+    Matrix eri = bsSet.mat_int_repulsion(nhfInt::EriOption(EriEngine::Hgp, 0.0), &stat);
+    EXPECT_EQ(stat.nPrimQuartet, ref.nPrimQuartet);
+    EXPECT_GT(stat.nPrimScreened, ref.nPrimScreened);
+
+    for (std::size_t i = 0; i < eriRef.size(); ++i) {
+        EXPECT_NEAR(eri(i), eriRef(i), 1e-8);
+    }
+    Matrix S = bsSet.mat_int_overlap();
+    for (std::size_t i = 0; i < SRef.size(); ++i) {
+        EXPECT_NEAR(S(i), SRef(i), 1e-8);
+    }
+}
+
+
+TEST(TestBasisSet, TestBoysPolicy) {
+    BasisSet bsSet = test_basis_set_df();
+
+    // the table as an explicit policy is the default, (fd|ff)
+    nhfInt::EriClass eri, ref;
+    const nhfInt::tho::Shell &f = bsSet.shList[3], &d = bsSet.shList[2];
+    ASSERT_TRUE(f.L == 3 && d.L == 2);
+    for (EriEngine engine : {EriEngine::Tho, EriEngine::Hgp, EriEngine::Md, EriEngine::Gen}) {
+        nhfInt::int_repulsion(engine, ref, f, d, f, f, bsSet.spList(3, 2), bsSet.spList(3, 3));
+        nhfInt::int_repulsion(engine, eri, f, d, f, f, bsSet.spList(3, 2), bsSet.spList(3, 3),
+                              nhfBoys::boys_taylor());
+        ASSERT_EQ(eri.size(), ref.size());
+        for (std::size_t k = 0; k < ref.size(); ++k) {
+            EXPECT_EQ(eri.eriVal[k], ref.eriVal[k]);
+        }
+    }
+
+    // a looser Boys function, the integrals are of order one
+    for (EriEngine engine : {EriEngine::Hgp, EriEngine::Gen}) {
+        Matrix full = bsSet.mat_int_repulsion(nhfInt::EriOption(engine, 0.0));
+        Matrix loose = bsSet.mat_int_repulsion(nhfInt::EriOption(engine, 0.0, 1e-10));
+        for (std::size_t i = 0; i < full.size(); ++i) {
+            EXPECT_NEAR(loose(i), full(i), 1e-9);
+        }
+    }
+}
+
+
+TEST(TestBasisSet, TestPureOverlap) {
+    // one primitive of every L on one atom, the solid harmonics of
+    // different L or m are orthogonal by their angular part
+    nhfInt::AtomBasis atm({
+        "X     0",
+        "S    1   1.00",
+        "0.9000000000E+00       1.0000000",
+        "P    1   1.00",
+        "0.8000000000E+00       1.0000000",
+        "D    1   1.00",
+        "0.7000000000E+00       1.0000000",
+        "F    1   1.00",
+        "0.6000000000E+00       1.0000000",
+        "G    1   1.00",
+        "0.5000000000E+00       1.0000000",
+        "H    1   1.00",
+        "0.4000000000E+00       1.0000000",
+        "I    1   1.00",
+        "0.3000000000E+00       1.0000000"
+    });
+    BasisSet bsSet(atm, Vec3d(0.1, -0.2, 0.3));
+    EXPECT_EQ(bsSet.n_func(), bsSet.size());
+
+    bsSet.set_pure(true);
+    EXPECT_EQ(bsSet.n_func(), 1u + 3 + 5 + 7 + 9 + 11 + 13);
+
+    Matrix S = bsSet.mat_int_overlap();
+    ASSERT_EQ(S.rows(), bsSet.n_func());
+    for (std::size_t i = 0; i < S.rows(); ++i) {
+    for (std::size_t j = 0; j < S.cols(); ++j) {
+        EXPECT_NEAR(S(i,j), i == j ? 1.0 : 0.0, absErr) << i << " " << j;
+    }}
+}
+
+
+TEST(TestBasisSet, TestPureRepulsion) {
+    BasisSet bsSet = test_basis_set_df();
+    Matrix cart = bsSet.mat_int_repulsion(nhfInt::EriOption(EriEngine::Hgp, 0.0));
+    std::size_t nCart = bsSet.size();
+
+    bsSet.set_pure(true);
+    Matrix pure = bsSet.mat_int_repulsion(nhfInt::EriOption(EriEngine::Hgp, 0.0));
+    std::size_t nPure = bsSet.n_func();
+    ASSERT_LT(nPure, nCart);
+    ASSERT_EQ(pure.size(), nhfInt::idx4(nPure-1, nPure-1, nPure-1, nPure-1) + 1);
+
+    // T(p, c) of the whole basis, the identity on s and p shells
+    std::vector<double> T(nPure * nCart, 0.0);
+    for (const nhfInt::tho::Shell &sh : bsSet.shList) {
+        const std::vector<double> &t = nhfInt::cart_to_pure(sh.L);
+        for (std::size_t p = 0; p < sh.nfunc(); ++p) {
+        for (std::size_t c = 0; c < sh.size(); ++c) {
+            T[(sh.func + p) * nCart + sh.offset + c] =
+                sh.pure ? t[p * sh.size() + c] : double(p == c);
+        }}
+    }
+
+    // transform the indices one by one, the last index first
+    std::vector<double> val(nCart * nCart * nCart * nCart);
+    for (std::size_t i = 0; i < nCart; ++i) {
+    for (std::size_t j = 0; j < nCart; ++j) {
+    for (std::size_t k = 0; k < nCart; ++k) {
+    for (std::size_t l = 0; l < nCart; ++l) {
+        val[((i * nCart + j) * nCart + k) * nCart + l] = cart(nhfInt::idx4(i, j, k, l));
+    }}}}
+    std::size_t dims[4] = {nCart, nCart, nCart, nCart};
+    for (int k = 3; k >= 0; --k) {
+        std::size_t outer = 1, inner = 1;
+        for (int i = 0; i < k; ++i) outer *= dims[i];
+        for (int i = k + 1; i < 4; ++i) inner *= dims[i];
+        std::vector<double> out(outer * nPure * inner, 0.0);
+        for (std::size_t o = 0; o < outer; ++o) {
+        for (std::size_t p = 0; p < nPure; ++p) {
+        for (std::size_t c = 0; c < nCart; ++c) {
+            double t = T[p * nCart + c];
+            if (t == 0.0) continue;
+            for (std::size_t i = 0; i < inner; ++i) {
+                out[(o * nPure + p) * inner + i] += t * val[(o * nCart + c) * inner + i];
+            }
+        }}}
+        val.swap(out);
+        dims[k] = nPure;
+    }
+
+    for (std::size_t i = 0; i < nPure; ++i) {
+    for (std::size_t j = 0; j <= i; ++j) {
+    for (std::size_t k = 0; k < nPure; ++k) {
+    for (std::size_t l = 0; l <= k; ++l) {
+        EXPECT_NEAR(pure(nhfInt::idx4(i, j, k, l)),
+                    val[((i * nPure + j) * nPure + k) * nPure + l], absErr);
+    }}}}
+
+    // the one-electron matrices shrink as well
+    Matrix S = bsSet.mat_int_overlap();
+    EXPECT_EQ(S.rows(), nPure);
+}
+
+
+TEST(TestBasisSet, TestThreads) {
+    BasisSet bsSet = test_basis_set_df();
+    bsSet.set_pure(true);
+    std::vector<int> zval = {26, 1};
+    std::vector<Vec3d> geom = {Vec3d(0.2, 0.0, 0.1), Vec3d(-0.4, 1.3, 0.9)};
+
+    nhfInt::set_num_threads(1);
+    EXPECT_EQ(nhfInt::num_threads(), 1);
+    nhfInt::EriStat stat1;
+    std::vector<Matrix> serial = {
+        bsSet.mat_int_overlap(), bsSet.mat_int_kinetic(),
+        bsSet.mat_int_nuclear(zval, geom), bsSet.mat_schwarz(),
+        bsSet.mat_int_repulsion(nhfInt::EriOption(EriEngine::Hgp, 1e-8), &stat1)
+    };
+
+    // the same bits on more threads than quartets of some rows
+    nhfInt::set_num_threads(3);
+    nhfInt::EriStat stat3;
+    std::vector<Matrix> parallel = {
+        bsSet.mat_int_overlap(), bsSet.mat_int_kinetic(),
+        bsSet.mat_int_nuclear(zval, geom), bsSet.mat_schwarz(),
+        bsSet.mat_int_repulsion(nhfInt::EriOption(EriEngine::Hgp, 1e-8), &stat3)
+    };
+    nhfInt::set_num_threads(0);
+
+    for (std::size_t m = 0; m < serial.size(); ++m) {
+        ASSERT_EQ(parallel[m].size(), serial[m].size());
+        for (std::size_t i = 0; i < serial[m].size(); ++i) {
+            EXPECT_EQ(parallel[m](i), serial[m](i));
+        }
+    }
+    EXPECT_EQ(stat3.nScreened, stat1.nScreened);
+    EXPECT_EQ(stat3.nPrimScreened, stat1.nPrimScreened);
+}
+
+TEST(TestBasisSet, TestTaskPlan) {
+    // a few expensive tasks among many cheap ones
+    std::vector<double> cost;
+    for (std::size_t t = 0; t < 500; ++t) {
+        cost.push_back(t % 97 == 0 ? 1e4 : 1.0 + t % 5);
+    }
+
+    nhfInt::TaskPlan plan(cost, 3);
+    ASSERT_EQ(plan.n_thread(), 3);
+    std::vector<int> seen(cost.size(), 0);
+    for (std::size_t k = 0; k < plan.size(); ++k) {
+        double sum = 0.0;
+        for (std::size_t t = plan.first(k); t < plan.last(k); ++t) {
+            ++seen[t];
+            sum += cost[t];
+        }
+        EXPECT_DOUBLE_EQ(plan.cost(k), sum);
+        if (k > 0) {
+            EXPECT_LE(plan.cost(k), plan.cost(k-1));
+        }
+    }
+    for (int s : seen) EXPECT_EQ(s, 1);
+
+    // every task runs once, on one of the workers
+    struct Counter {
+        std::vector<int> *hit;
+        std::size_t       n;
+        void operator()(std::size_t t) { ++(*hit)[t]; ++n; }
+    };
+    std::vector<std::vector<int>> hit(3, std::vector<int>(cost.size(), 0));
+    std::vector<Counter> worker = {{&hit[0], 0}, {&hit[1], 0}, {&hit[2], 0}};
+    nhfInt::run_tasks(plan, worker);
+    EXPECT_EQ(worker[0].n + worker[1].n + worker[2].n, cost.size());
+    for (std::size_t t = 0; t < cost.size(); ++t) {
+        EXPECT_EQ(hit[0][t] + hit[1][t] + hit[2][t], 1);
+    }
+}
+
+TEST(TestBasisSet, TestDirectJK) {
+    for (bool pure : {false, true}) {
+        BasisSet bsSet = test_basis_set_df();
+        bsSet.set_pure(pure);
+        Matrix D = test_density(bsSet.n_func());
+
+        // the same quartets as the stored integrals, screened or not
+        for (double thresh : {0.0, 1e-6}) {
+            nhfInt::EriOption opt(EriEngine::Hgp, thresh);
+            nhfInt::EriStat statEri, statJK;
+            Matrix Jref, Kref, J, K;
+            jk_from_eri(bsSet.mat_int_repulsion(opt, &statEri), D, Jref, Kref);
+
+            bsSet.mat_jk(D, J, K, opt, &statJK);
+            expect_same_matrix(J, Jref, 1e-10);
+            expect_same_matrix(K, Kref, 1e-10);
+            EXPECT_EQ(statJK.nScreened, statEri.nScreened);
+
+            nhfInt::set_num_threads(3);
+            bsSet.mat_jk(D, J, K, opt);
+            nhfInt::set_num_threads(0);
+            expect_same_matrix(J, Jref, 1e-10);
+            expect_same_matrix(K, Kref, 1e-10);
+        }
+    }
+}
+
+TEST(TestBasisSet, TestIncrementalJK) {
+    // far enough apart for small Schwarz bounds between the atoms
+    BasisSet bsSet = test_basis_set_df(Vec3d(-2.4, 5.3, 4.9));
+    bsSet.set_pure(true);
+    std::size_t n = bsSet.n_func();
+    Matrix D = test_density(n), P(n, n, 0.0);
+    for (std::size_t i = 0; i < n; ++i) {
+    for (std::size_t j = 0; j <= i; ++j) {
+        P(i,j) = P(j,i) = std::cos(0.9 * i - 0.4 * j);
+    }}
+
+    // densities converging as D + 10^-k P, a full build every 3rd update
+    nhfInt::IncrementalJK jk(bsSet, nhfInt::EriOption(EriEngine::Hgp, 1e-12, 0.0, 1e-10), 3);
+    std::size_t nFull = 0;
+    for (int k = 1; k <= 7; ++k) {
+        Matrix Dk = D + std::pow(10.0, -k) * P;
+        jk.update(Dk);
+        EXPECT_EQ(jk.full, k % 3 == 1);
+        if (jk.full) {
+            nFull = jk.stat.nQuartet - jk.stat.nScreened;
+        } else {
+            EXPECT_LT(jk.stat.nQuartet - jk.stat.nScreened, nFull);
+        }
+
+        Matrix J, K;
+        bsSet.mat_jk(Dk, J, K, nhfInt::EriOption(EriEngine::Hgp, 1e-12));
+        expect_same_matrix(jk.J, J, 1e-9);
+        expect_same_matrix(jk.K, K, 1e-9);
+    }
+
+    jk.reset();
+    jk.update(D);
+    EXPECT_TRUE(jk.full);
+}
+
+TEST(TestBasisSet, TestDensityScreening) {
+    BasisSet bsSet = test_basis_set_df(Vec3d(-2.4, 5.3, 4.9));
+    bsSet.set_pure(true);
+    std::size_t n = bsSet.n_func();
+
+    // a density on the heavy atom only, its last two shells are the light one
+    std::size_t nHeavy = bsSet.shList[bsSet.shList.size() - 2].func;
+    Matrix D = test_density(n);
+    for (std::size_t i = 0; i < n; ++i) {
+    for (std::size_t j = 0; j < n; ++j) {
+        if (i >= nHeavy || j >= nHeavy) D(i,j) = 0.0;
+    }}
+
+    Matrix Jref, Kref, J, K;
+    nhfInt::EriStat plain, weighted;
+    bsSet.mat_jk(D, Jref, Kref, nhfInt::EriOption(EriEngine::Hgp, 1e-12), &plain);
+    bsSet.mat_jk(D, J, K, nhfInt::EriOption(EriEngine::Hgp, 1e-12, 0.0, 1e-12), &weighted);
+
+    // the quartets without a heavy pair in J or K are skipped, and they
+    // did not add anything. The Schwarz bound skips the same quartets.
+    EXPECT_EQ(plain.nDensityScreened, 0u);
+    EXPECT_GT(weighted.nDensityScreened, 0u);
+    EXPECT_EQ(weighted.nScreened - weighted.nDensityScreened, plain.nScreened);
+    expect_same_matrix(J, Jref, 1e-11);
+    expect_same_matrix(K, Kref, 1e-11);
+}
+
+TEST(TestBasisSet, TestEriTensor) {
+    BasisSet bsSet = test_basis_set_df();
+    bsSet.set_pure(true);
+    std::size_t n = bsSet.n_func();
+    nhfInt::EriOption opt(EriEngine::Hgp, 1e-10);
+
+    Matrix eri = bsSet.mat_int_repulsion(opt);
+    nhfInt::EriTensor tensor = bsSet.eri_tensor(opt);
+    ASSERT_EQ(tensor.n_func(), n);
+    ASSERT_EQ(tensor.size(), eri.size());
+    for (std::size_t x = 0; x < eri.size(); ++x) {
+        EXPECT_EQ(tensor.data()[x], eri(x));
+    }
+    EXPECT_EQ(tensor(3, 7, 1, 2), eri(nhfInt::idx4(7, 3, 2, 1)));
+    EXPECT_EQ(tensor.row(nhfInt::idx2(5, 4))[nhfInt::idx2(2, 3)], tensor(5, 4, 3, 2));
+
+    Matrix D = test_density(n), Jref, Kref, J, K;
+    jk_from_eri(eri, D, Jref, Kref);
+    for (int nThread : {1, 3}) {
+        nhfInt::set_num_threads(nThread);
+        nhfInt::EriTensor(n, eri).jk(D, J, K);
+        expect_same_matrix(J, Jref, 1e-10);
+        expect_same_matrix(K, Kref, 1e-10);
+    }
+    nhfInt::set_num_threads(0);
+}
+
+TEST(TestBasisSet, TestEriFile) {
+    BasisSet bsSet = test_basis_set_df();
+    bsSet.set_pure(true);
+    std::size_t n = bsSet.n_func();
+    nhfInt::EriOption opt(EriEngine::Hgp, 1e-8);
+    const char *fileName = "test_tho_basis.eri";
+
+    nhfInt::EriStat statEri, statFile;
+    Matrix eri = bsSet.mat_int_repulsion(opt, &statEri);
+    nhfInt::set_num_threads(3);
+    bsSet.write_eri_file(fileName, opt, &statFile);
+    nhfInt::set_num_threads(0);
+    EXPECT_EQ(statFile.nScreened, statEri.nScreened);
+
+    {
+        nhfInt::EriFile file(fileName);
+        ASSERT_EQ(file.n_func(), n);
+        EXPECT_EQ(file.n_block(), statEri.nQuartet - statEri.nScreened);
+
+        nhfInt::EriTensor tensor = file.tensor();
+        ASSERT_EQ(tensor.size(), eri.size());
+        for (std::size_t x = 0; x < eri.size(); ++x) {
+            EXPECT_EQ(tensor.data()[x], eri(x));
+        }
+
+        Matrix D = test_density(n), Jref, Kref, J, K;
+        jk_from_eri(eri, D, Jref, Kref);
+        file.jk(D, J, K);
+        expect_same_matrix(J, Jref, 1e-10);
+        expect_same_matrix(K, Kref, 1e-10);
+    }
+
+    // a block that reaches past the functions, or a file cut short, is
+    // refused before anything is read from the blocks. The OpenMP threads
+    // above are still alive, so the death tests run in a fresh process.
+    GTEST_FLAG_SET(death_test_style, "threadsafe");
+    std::string bytes;
+    {
+        std::ifstream ifs(fileName, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    }
+    nhfInt::EriFileHeader header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    auto write_file = [&](const std::string &text) {
+        std::ofstream ofs(fileName, std::ios::binary);
+        ofs.write(text.data(), text.size());
+    };
+
+    std::string bad = bytes;
+    nhfInt::EriBlockInfo info;
+    std::memcpy(&info, &bad[header.indexOffset], sizeof(info));
+    info.func[3] = std::uint32_t(n);
+    info.nfunc[3] = 1;
+    std::memcpy(&bad[header.indexOffset], &info, sizeof(info));
+    write_file(bad);
+    EXPECT_EXIT(nhfInt::EriFile file(fileName), ::testing::ExitedWithCode(255), "not an ERI file");
+
+    write_file(bytes.substr(0, header.indexOffset + sizeof(nhfInt::EriBlockInfo)));
+    EXPECT_EXIT(nhfInt::EriFile file(fileName), ::testing::ExitedWithCode(255), "not an ERI file");
+    std::remove(fileName);
+}
+
+TEST(TestBasisSet, TestEriStore) {
+    BasisSet bsSet = test_basis_set_df();
+    bsSet.set_pure(true);
+    std::size_t n = bsSet.n_func();
+    nhfInt::EriOption opt(EriEngine::Hgp, 1e-10);
+    Matrix eri = bsSet.mat_int_repulsion(opt);
+    Matrix D = test_density(n), Jref, Kref;
+    jk_from_eri(eri, D, Jref, Kref);
+
+    // smaller than the doubles, and smaller still with a looser bound
+    std::size_t lastBytes = eri.size() * sizeof(double);
+    for (double absErr : {1e-12, 1e-9, 1e-6}) {
+        nhfInt::set_num_threads(3);
+        nhfInt::EriStore store = bsSet.eri_store(absErr, opt);
+        nhfInt::set_num_threads(0);
+        EXPECT_LT(store.bytes(), lastBytes);
+        lastBytes = store.bytes();
+
+        // every integral within absErr, and J, K within absErr times the
+        // sum of |D| that each element of them contracts with
+        nhfInt::EriTensor tensor = store.tensor();
+        ASSERT_EQ(tensor.size(), eri.size());
+        for (std::size_t x = 0; x < eri.size(); ++x) {
+            EXPECT_NEAR(tensor.data()[x], eri(x), absErr * (1.0 + 1e-6));
+        }
+
+        double sumD = 0.0;
+        for (std::size_t x = 0; x < D.size(); ++x) {
+            sumD += std::abs(D(x));
+        }
+        Matrix J, K;
+        store.jk(D, J, K);
+        expect_same_matrix(J, Jref, absErr * sumD);
+        expect_same_matrix(K, Kref, absErr * sumD);
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "boysfun.hpp"
+#include <vector>
+#include <cstddef>
+
+namespace nhfBoys {
+
+// Piecewise Chebyshev interpolation of F_0 ~ F_maxN and of exp(-x) on
+// 0 <= x <= TABLE_MAX_X, equal intervals of one degree. The constructor
+// picks the lowest degree, and for it the fewest intervals (a power of
+// two, at most MAX_INTERVAL), whose relative error stays below tol.
+// The rounding of the reference values keeps the error above about
+// 1e-14; a tol that no degree and number of intervals reaches is
+// reported and ends the program.
+// all() interpolates F_m and exp(-x) and gets the lower orders from the
+// downward recursion, which does not increase the relative error.
+// Above TABLE_MAX_X and for n > maxN it is the same as boysfun.
+class BoysChebyshev : public BoysEvaluator {
+public:
+    static const int MAX_DEGREE   = 16;
+    static const int MAX_INTERVAL = 512;
+
+    double tol;         // requested relative error
+    double maxErr;      // largest relative error seen while choosing
+    int    maxN;
+    int    degree;
+    int    nInterval;
+
+    explicit BoysChebyshev(double tol, int maxN = MAX_N);
+
+    double operator()(int n, double x) const;
+
+    void all(int m, double x, double *fm) const override;
+    void all(int m, const double *x, std::size_t nx, double *fm) const override;
+
+private:
+    double              width, invWidth;
+    std::vector<double> coef;       // [(interval * (maxN+2) + n) * (degree+1) + k],
+                                    // n = maxN + 1 is exp(-(x - x_interval))
+    std::vector<double> expLeft;    // exp(-x_interval)
+
+    // Chebyshev series of row n on interval i at -1 <= t <= 1
+    double clenshaw(int n, int i, double t) const;
+
+    // F_n(x) and exp(-x) at x <= TABLE_MAX_X, n <= maxN
+    double eval(int n, double x) const;
+    double eval_exp(double x) const;
+
+    // coefficients of degree d on nInt intervals, returns the largest
+    // relative error at the points halfway between the nodes
+    double build(int d, int nInt);
+};
+
+// the BoysChebyshev of tol with the default maxN, built on the first call
+// for each tol and kept for the rest of the program
+const BoysChebyshev& boys_chebyshev(double tol);
+
+}   // namespace (nhfBoys)
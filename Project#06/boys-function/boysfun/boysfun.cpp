@@ -0,0 +1,119 @@
+#include "boysfun.hpp"
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+namespace nhfBoys {
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+
+const int TABLE_NX = int(TABLE_MAX_X / TABLE_STEP + 0.5) + 1;
+const int TABLE_NN = TABLE_MAX_N + 1;
+
+// F_n(x_t), n = 0 ~ TABLE_MAX_N, stored as [t * TABLE_NN + n].
+// F_TABLE_MAX_N comes from the series, the lower orders from the
+// downward recursion F_n = (2x F_n+1 + exp(-x)) / (2n+1), which is stable.
+class Table {
+public:
+    std::vector<double> val;
+
+    Table(): val(std::size_t(TABLE_NX) * TABLE_NN) {
+        for (int t = 0; t < TABLE_NX; ++t) {
+            double x = t * TABLE_STEP;
+            double ex = std::exp(-x);
+            double *f = &val[std::size_t(t) * TABLE_NN];
+            f[TABLE_MAX_N] = boysfun_series(TABLE_MAX_N, x);
+            for (int n = TABLE_MAX_N - 1; n >= 0; --n) {
+                f[n] = (2.0 * x * f[n+1] + ex) / (2 * n + 1);
+            }
+        }
+    }
+};
+
+const Table& table() {
+    static const Table tab;
+    return tab;
+}
+
+}   // namespace (anonymous)
+
+
+double boysfun_series(int n, double x) {
+    // every term is positive, so the sum keeps full relative precision
+    double term = 1.0 / (2.0 * n + 1);
+    double sum = term;
+    for (int k = 1; term > 1e-17 * sum; ++k) {
+        term *= 2.0 * x / (2.0 * n + 2.0 * k + 1);
+        sum += term;
+    }
+    return std::exp(-x) * sum;
+}
+
+namespace {
+
+// F_n(x) for x <= TABLE_MAX_X and n + TAYLOR_TERMS - 1 <= TABLE_MAX_N,
+// F_n(x_t + dx) = sum_k F_n+k(x_t) (-dx)^k / k!, in Horner form
+double taylor(const Table &tab, int n, double x) {
+    int t = int(x / TABLE_STEP + 0.5);
+    double mdx = t * TABLE_STEP - x;
+    const double *f = &tab.val[std::size_t(t) * TABLE_NN + n];
+
+    double ret = f[TAYLOR_TERMS - 1];
+    for (int k = TAYLOR_TERMS - 1; k > 0; --k) {
+        ret = f[k-1] + ret * mdx / k;
+    }
+    return ret;
+}
+
+}   // namespace (anonymous)
+
+double boysfun(int n, double x) {
+    if (x > TABLE_MAX_X) {
+        double ret = 0.5 * std::sqrt(PI / x);
+        for (int k = 1; k <= n; ++k) {
+            ret *= (2 * k - 1) / (2.0 * x);
+        }
+        return ret;
+    }
+    if (n + TAYLOR_TERMS - 1 > TABLE_MAX_N) return boysfun_series(n, x);
+    return taylor(table(), n, x);
+}
+
+void boysfun_all(int m, double x, double *fm) {
+    boysfun_all(m, &x, 1, fm);
+}
+
+void boysfun_all(int m, const double *x, std::size_t nx, double *fm) {
+    // chunks of CHUNK arguments, so that exp(-x) fits on the stack. The
+    // downward recursion is also right above TABLE_MAX_X, there it starts
+    // from the asymptotic F_m and exp(-x) is negligible.
+    const std::size_t CHUNK = 64;
+    double ex[CHUNK];
+    for (std::size_t i0 = 0; i0 < nx; i0 += CHUNK) {
+        std::size_t len = std::min(CHUNK, nx - i0);
+        const double *xc = x + i0;
+        double *top = fm + std::size_t(m) * nx + i0;
+        for (std::size_t i = 0; i < len; ++i) {
+            top[i] = boysfun(m, xc[i]);
+            ex[i] = std::exp(-xc[i]);
+        }
+
+        for (int n = m - 1; n >= 0; --n) {
+            const double *up = fm + std::size_t(n + 1) * nx + i0;
+            double *cur = fm + std::size_t(n) * nx + i0;
+            for (std::size_t i = 0; i < len; ++i) {
+                cur[i] = (2.0 * xc[i] * up[i] + ex[i]) / (2 * n + 1);
+            }
+        }
+    }
+}
+
+const BoysEvaluator& boys_taylor() {
+    static const BoysTaylor eval;
+    return eval;
+}
+
+}   // namespace (nhfBoys)
@@ -0,0 +1,188 @@
+// Time and accuracy of the Boys function implementations.
+//
+// For every x region it prints the time per call and the largest relative
+// error against boys_quadrature, first for single values F_n(x), then for
+// whole vectors F_0(x) ~ F_m(x) as the integral kernels use them.
+#include "boysfun.hpp"
+#include "boys_chebyshev.hpp"
+#include "boys_reference.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+namespace {
+
+// largest order of real integrals, 4 l_max with i functions
+const int NMAX = 24;
+const std::size_t NSAMPLE = 2000;
+
+// boysfun of Project#04 tho_int.cpp: the series below x = 30, erf and
+// the upward recursion above
+double boysfun_recursive(int n, double x) {
+    if (x < 30.0) {
+        double term = 1.0 / (2.0 * n + 1);
+        double sum = term;
+        for (int k = 1; term > 1e-17 * sum; ++k) {
+            term *= 2.0 * x / (2.0 * n + 2.0 * k + 1);
+            sum += term;
+        }
+        return std::exp(-x) * sum;
+    }
+    if (n == 0) return 0.5 * std::sqrt(3.14159265358979323846 / x) * std::erf(std::sqrt(x));
+    return 0.5 / x * ( (2*n -1) * boysfun_recursive(n-1, x) - std::exp(-x) );
+}
+
+struct Region {
+    const char *name;
+    double      xmin, xmax;
+};
+
+const Region REGION[] = {
+    {"small x",    0.0,    1.0},
+    {"table",      0.0,    150.0},
+    {"boundary",   140.0,  160.0},
+    {"asymptotic", 150.0,  1000.0},
+};
+
+struct Sample {
+    std::vector<double> x;
+    std::vector<int>    n;
+    std::vector<std::vector<long double>> ref;  // F_0 ~ F_NMAX of x
+};
+
+Sample make_sample(const Region &r) {
+    std::mt19937 gen(2023);
+    std::uniform_real_distribution<double> ux(r.xmin, r.xmax);
+    std::uniform_int_distribution<int> un(0, NMAX);
+
+    Sample s;
+    for (std::size_t i = 0; i < NSAMPLE; ++i) {
+        s.x.push_back(ux(gen));
+        s.n.push_back(un(gen));
+        s.ref.push_back(boys_quadrature(NMAX, s.x.back()));
+    }
+    return s;
+}
+
+double rel_err(double val, long double ref) {
+    return double(std::fabs((val - ref) / ref));
+}
+
+// ns of one call of f(), which does nCall calls, repeated for 0.1 s
+template <typename F>
+double time_ns(F f, std::size_t nCall) {
+    typedef std::chrono::steady_clock Clock;
+    std::size_t nRep = 0;
+    Clock::time_point t0 = Clock::now();
+    double sec = 0.0;
+    do {
+        f();
+        ++nRep;
+        sec = std::chrono::duration<double>(Clock::now() - t0).count();
+    } while (sec < 0.1);
+    return sec * 1e9 / double(nRep * nCall);
+}
+
+volatile double sink;
+
+void print_row(const char *variant, double ns, double err) {
+    std::printf("    %-24s %10.1f %14.3e\n", variant, ns, err);
+}
+
+
+// F_n(x) one at a time, n random in 0 ~ NMAX
+template <typename F>
+void bench_single(const char *variant, F boys, const Sample &s) {
+    double err = 0.0;
+    for (std::size_t i = 0; i < NSAMPLE; ++i) {
+        err = std::max(err, rel_err(boys(s.n[i], s.x[i]), s.ref[i][s.n[i]]));
+    }
+    double ns = time_ns([&]() {
+        double sum = 0.0;
+        for (std::size_t i = 0; i < NSAMPLE; ++i) {
+            sum += boys(s.n[i], s.x[i]);
+        }
+        sink = sum;
+    }, NSAMPLE);
+    print_row(variant, ns, err);
+}
+
+// F_0(x) ~ F_m(x) of every x, boysAll(m, x, fm)
+template <typename F>
+void bench_all(const char *variant, F boysAll, int m, const Sample &s) {
+    std::vector<double> fm(m + 1);
+    double err = 0.0;
+    for (std::size_t i = 0; i < NSAMPLE; ++i) {
+        boysAll(m, s.x[i], fm.data());
+        for (int n = 0; n <= m; ++n) {
+            err = std::max(err, rel_err(fm[n], s.ref[i][n]));
+        }
+    }
+    double ns = time_ns([&]() {
+        double sum = 0.0;
+        for (std::size_t i = 0; i < NSAMPLE; ++i) {
+            boysAll(m, s.x[i], fm.data());
+            sum += fm[0];
+        }
+        sink = sum;
+    }, NSAMPLE);
+    print_row(variant, ns, err);
+}
+
+// F_0(x) ~ F_m(x) of all samples in one batch call, time per x
+void bench_batch(const char *variant, const nhfBoys::BoysEvaluator &boys,
+                 int m, const Sample &s) {
+    std::vector<double> fm((m + 1) * NSAMPLE);
+    boys.all(m, s.x.data(), NSAMPLE, fm.data());
+    double err = 0.0;
+    for (std::size_t i = 0; i < NSAMPLE; ++i) {
+        for (int n = 0; n <= m; ++n) {
+            err = std::max(err, rel_err(fm[n * NSAMPLE + i], s.ref[i][n]));
+        }
+    }
+    double ns = time_ns([&]() {
+        boys.all(m, s.x.data(), NSAMPLE, fm.data());
+        sink = fm[0];
+    }, NSAMPLE);
+    print_row(variant, ns, err);
+}
+
+}   // namespace (anonymous)
+
+
+int main() {
+    const nhfBoys::BoysChebyshev cheb10(1e-10), cheb14(1e-14);
+    std::printf("chebyshev 1e-10: degree %d, %d intervals\n", cheb10.degree, cheb10.nInterval);
+    std::printf("chebyshev 1e-14: degree %d, %d intervals\n\n", cheb14.degree, cheb14.nInterval);
+
+    for (const Region &r : REGION) {
+        Sample s = make_sample(r);
+        std::printf("%s, %g <= x <= %g\n", r.name, r.xmin, r.xmax);
+        std::printf("    %-24s %10s %14s\n", "F_n(x), 0 <= n <= 24", "ns/call", "max rel err");
+        bench_single("recursive", boysfun_recursive, s);
+        bench_single("tabulated", nhfBoys::boysfun, s);
+        bench_single("chebyshev 1e-10", cheb10, s);
+        bench_single("chebyshev 1e-14", cheb14, s);
+
+        for (int m : {8, NMAX}) {
+            std::printf("    F_0 ~ F_%-2d %13s %10s %14s\n", m, "", "ns/x", "max rel err");
+            bench_all("recursive", [](int m, double x, double *fm) {
+                for (int n = 0; n <= m; ++n) fm[n] = boysfun_recursive(n, x);
+            }, m, s);
+            bench_all("tabulated", [](int m, double x, double *fm) {
+                for (int n = 0; n <= m; ++n) fm[n] = nhfBoys::boysfun(n, x);
+            }, m, s);
+            bench_all("all orders", [](int m, double x, double *fm) {
+                nhfBoys::boysfun_all(m, x, fm);
+            }, m, s);
+            bench_batch("all orders, batch", nhfBoys::boys_taylor(), m, s);
+            bench_batch("chebyshev 1e-10, batch", cheb10, m, s);
+            bench_batch("chebyshev 1e-14, batch", cheb14, m, s);
+        }
+        std::printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+
+// reference values of the Boys function for the test and the benchmark
+
+// F_0(x) ~ F_nmax(x) by composite Gauss-Legendre quadrature in long
+// double, 50 intervals of 20 points on [0,1]
+inline std::vector<long double> boys_quadrature(int nmax, long double x) {
+    static std::vector<long double> node, weight;
+    const int np = 20;
+    if (node.empty()) {
+        const long double pi = 3.141592653589793238462643383279L;
+        for (int i = 0; i < np; ++i) {
+            // Newton iteration on P_np, from the Chebyshev guess
+            long double z = std::cos(pi * (i + 0.75L) / (np + 0.5L));
+            long double dp = 0.0L;
+            for (int it = 0; it < 100; ++it) {
+                long double p0 = 1.0L, p1 = z;
+                for (int k = 2; k <= np; ++k) {
+                    long double p2 = ((2*k - 1) * z * p1 - (k - 1) * p0) / k;
+                    p0 = p1; p1 = p2;
+                }
+                dp = np * (z * p1 - p0) / (z * z - 1.0L);
+                long double dz = p1 / dp;
+                z -= dz;
+                if (std::fabs(dz) < 1e-19L) break;
+            }
+            node.push_back(z);
+            weight.push_back(2.0L / ((1.0L - z * z) * dp * dp));
+        }
+    }
+
+    const int nInterval = 50;
+    const long double h = 1.0L / nInterval;
+    std::vector<long double> ret(nmax + 1, 0.0L);
+    for (int s = 0; s < nInterval; ++s) {
+        for (int i = 0; i < np; ++i) {
+            long double t = (s + 0.5L + 0.5L * node[i]) * h;
+            long double val = 0.5L * h * weight[i] * std::exp(-x * t * t);
+            for (int n = 0; n <= nmax; ++n) {
+                ret[n] += val;
+                val *= t * t;
+            }
+        }
+    }
+    return ret;
+}
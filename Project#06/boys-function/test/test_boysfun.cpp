@@ -0,0 +1,108 @@
+#include "boysfun.hpp"
+#include "boys_chebyshev.hpp"
+#include "boys_reference.hpp"
+#include <gtest/gtest.h>
+#include <vector>
+#include <cmath>
+#include <cstddef>
+
+using nhfBoys::boysfun;
+
+static const int    MAX_N  = nhfBoys::MAX_N;
+static const double relErr = 1e-14;
+
+static void expect_quadrature(double x) {
+    std::vector<long double> ref = boys_quadrature(MAX_N, x);
+    for (int n = 0; n <= MAX_N; ++n) {
+        double r = double(ref[n]);
+        EXPECT_NEAR(boysfun(n, x), r, relErr * r) << "n = " << n << ", x = " << x;
+    }
+}
+
+
+TEST(TestBoysFun, TestZero) {
+    for (int n = 0; n <= MAX_N; ++n) {
+        EXPECT_NEAR(boysfun(n, 0.0), 1.0 / (2 * n + 1), 1e-16);
+    }
+}
+
+TEST(TestBoysFun, TestQuadrature) {
+    // table points, midpoints between them and the asymptotic branch
+    for (double x = 0.0; x < 200.0; x += 0.0731) {
+        expect_quadrature(x);
+    }
+    for (double x : {0.05, 0.0499999, 0.15, 29.95, 149.95, 150.0, 150.0001, 1e3}) {
+        expect_quadrature(x);
+    }
+}
+
+TEST(TestBoysFun, TestSeries) {
+    // n above the table
+    for (int n = MAX_N + 1; n <= 48; ++n) {
+        for (double x : {0.0, 0.3, 7.0, 42.0, 140.0}) {
+            double ref = double(boys_quadrature(n, x)[n]);
+            EXPECT_NEAR(boysfun(n, x), ref, relErr * ref) << "n = " << n << ", x = " << x;
+        }
+    }
+}
+
+TEST(TestBoysFun, TestAllOrders) {
+    std::vector<double> fm(MAX_N + 1);
+    for (double x = 0.0; x < 200.0; x += 0.0913) {
+        std::vector<long double> ref = boys_quadrature(MAX_N, x);
+        for (int m : {0, 4, 17, MAX_N}) {
+            nhfBoys::boysfun_all(m, x, fm.data());
+            for (int n = 0; n <= m; ++n) {
+                double r = double(ref[n]);
+                EXPECT_NEAR(fm[n], r, relErr * r) << "n = " << n << ", x = " << x;
+            }
+        }
+    }
+}
+
+TEST(TestBoysFun, TestBatch) {
+    // more arguments than one chunk, below and above the table
+    std::vector<double> x;
+    for (double v = 0.0; v < 400.0; v += 1.37) {
+        x.push_back(v);
+    }
+    std::size_t nx = x.size();
+
+    const int m = 12;
+    std::vector<double> fm((m + 1) * nx), one(m + 1);
+    nhfBoys::boysfun_all(m, x.data(), nx, fm.data());
+    for (std::size_t i = 0; i < nx; ++i) {
+        nhfBoys::boysfun_all(m, x[i], one.data());
+        for (int n = 0; n <= m; ++n) {
+            EXPECT_EQ(fm[n * nx + i], one[n]);
+        }
+    }
+}
+
+TEST(TestBoysFun, TestChebyshev) {
+    const nhfBoys::BoysChebyshev loose(1e-10), tight(1e-14);
+    EXPECT_LE(loose.maxErr, 1e-10);
+    EXPECT_LE(tight.maxErr, 1e-14);
+    EXPECT_LE(loose.degree, tight.degree);
+
+    // below the rounding of the reference no table is accurate enough
+    EXPECT_EXIT(nhfBoys::BoysChebyshev cheb(1e-16), ::testing::ExitedWithCode(255), "cannot reach");
+
+    std::vector<double> fm(MAX_N + 1);
+    for (const nhfBoys::BoysChebyshev *cheb : {&loose, &tight}) {
+        for (double x = 0.0; x < 200.0; x += 0.0913) {
+            std::vector<long double> ref = boys_quadrature(MAX_N, x);
+            for (int n = 0; n <= MAX_N; ++n) {
+                double r = double(ref[n]);
+                EXPECT_NEAR((*cheb)(n, x), r, cheb->tol * r) << "n = " << n << ", x = " << x;
+            }
+            for (int m : {0, 9, MAX_N}) {
+                cheb->all(m, x, fm.data());
+                for (int n = 0; n <= m; ++n) {
+                    double r = double(ref[n]);
+                    EXPECT_NEAR(fm[n], r, cheb->tol * r) << "n = " << n << ", x = " << x;
+                }
+            }
+        }
+    }
+}